@@ -0,0 +1,129 @@
+/**
+ * @file benchmark.cpp
+ * @brief micro-benchmark of the DayTrain seat inventory on long trains
+ *
+ * build: g++ -std=c++17 -O3 [-mavx2] -Isrc -Ilibs -I../database/src/include
+ *        benchmark.cpp src/TrainSystem.cpp src/Command.cpp libs/Library.cpp
+ *
+ */
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+#include "TrainSystem.h"
+
+#define STATION_NUMBER 100
+#define SEAT_NUMBER 100000
+#define NUMBER 10000000
+#define PENDING_NUMBER 64
+
+using namespace thomas;  // NOLINT
+
+/* the linear loops DayTrain used before; noinline to match the out-of-line DayTrain */
+struct NaiveDayTrain {
+  int seat_num[maxn];
+
+  __attribute__((noinline)) int query_seat(int l, int r) const {
+    int ans = MAX_INT;
+    for (int i = l; i <= r; ++i) ans = std::min(ans, seat_num[i]);
+    return ans;
+  }
+
+  __attribute__((noinline)) void modify_seat(int l, int r, int val) {
+    for (int i = l; i <= r; ++i) seat_num[i] += val;
+  }
+};
+
+/* blocked range-min: exact values plus the minimum of every SEAT_BLOCK stations */
+#define SEAT_BLOCK 16
+#define SEAT_BLOCK_NUM ((maxn + SEAT_BLOCK - 1) / SEAT_BLOCK)
+struct BlockedDayTrain {
+  int seat_num[maxn], block_min[SEAT_BLOCK_NUM];
+
+  void Pull(int b) {
+    block_min[b] = MAX_INT;
+    for (int i = b * SEAT_BLOCK; i < std::min(maxn, (b + 1) * SEAT_BLOCK); ++i)
+      block_min[b] = std::min(block_min[b], seat_num[i]);
+  }
+
+  __attribute__((noinline)) int query_seat(int l, int r) const {
+    int bl = l / SEAT_BLOCK, br = r / SEAT_BLOCK, ans = MAX_INT;
+    if (bl == br) {
+      for (int i = l; i <= r; ++i) ans = std::min(ans, seat_num[i]);
+      return ans;
+    }
+    for (int i = l; i < (bl + 1) * SEAT_BLOCK; ++i) ans = std::min(ans, seat_num[i]);
+    for (int b = bl + 1; b < br; ++b) ans = std::min(ans, block_min[b]);
+    for (int i = br * SEAT_BLOCK; i <= r; ++i) ans = std::min(ans, seat_num[i]);
+    return ans;
+  }
+
+  __attribute__((noinline)) void modify_seat(int l, int r, int val) {
+    int bl = l / SEAT_BLOCK, br = r / SEAT_BLOCK;
+    for (int i = l; i <= r; ++i) seat_num[i] += val;
+    for (int b = bl + 1; b < br; ++b) block_min[b] += val;
+    Pull(bl);
+    if (br != bl) Pull(br);
+  }
+};
+
+template <class T>
+long long Buy(T *train, std::mt19937 *gen) {  // NOLINT
+  long long check = 0;
+  for (int i = 0; i < NUMBER; ++i) {
+    int s = (*gen)() % (STATION_NUMBER - 1) + 1, t = (*gen)() % (STATION_NUMBER - 1) + 1;
+    if (s > t) std::swap(s, t);
+    /* query the interval, then take (or give back) one seat */
+    int seat = train->query_seat(s, t);
+    check += seat;
+    train->modify_seat(s, t, seat > SEAT_NUMBER / 2 ? -1 : 1);
+  }
+  return check;
+}
+
+template <class T>
+long long Refund(T *train, std::mt19937 *gen) {  // NOLINT
+  long long check = 0;
+  int from[PENDING_NUMBER], to[PENDING_NUMBER];
+  for (int i = 0; i < NUMBER / PENDING_NUMBER; ++i) {
+    /* one refund followed by a scan of the pending orders, as refund_ticket does */
+    for (int j = 0; j < PENDING_NUMBER; ++j) {
+      from[j] = (*gen)() % (STATION_NUMBER - 1) + 1, to[j] = (*gen)() % (STATION_NUMBER - 1) + 1;
+      if (from[j] > to[j]) std::swap(from[j], to[j]);
+    }
+    train->modify_seat(1, STATION_NUMBER - 1, 1);
+    for (int j = 0; j < PENDING_NUMBER; ++j) {
+      int seat = train->query_seat(from[j], to[j]);
+      check += seat;
+      if (seat > SEAT_NUMBER / 2) train->modify_seat(from[j], to[j], -1);
+    }
+  }
+  return check;
+}
+
+template <class T>
+void Run(const char *name, T *train) {  // NOLINT
+  std::mt19937 gen(2022);
+  auto begin = std::chrono::system_clock::now();
+  long long check1 = Buy(train, &gen);
+  auto middle = std::chrono::system_clock::now();
+  long long check2 = Refund(train, &gen);
+  auto end = std::chrono::system_clock::now();
+  std::cout << name << " buy cost:" << 1.0 * (middle - begin).count() / 1e9  // NOLINT
+            << " refund cost:" << 1.0 * (end - middle).count() / 1e9       // NOLINT
+            << " check:" << check1 << " " << check2 << std::endl;
+}
+
+int main() {
+  NaiveDayTrain naive;
+  BlockedDayTrain blocked;
+  for (int i = 0; i < maxn; ++i) naive.seat_num[i] = blocked.seat_num[i] = SEAT_NUMBER;
+  for (int b = 0; b < SEAT_BLOCK_NUM; ++b) blocked.Pull(b);
+  DayTrain day_train(STATION_NUMBER, SEAT_NUMBER);
+
+  std::cout << NUMBER << " " << STATION_NUMBER << std::endl;
+  Run("naive", &naive);
+  Run("blocked", &blocked);
+  Run("day_train", &day_train);
+}
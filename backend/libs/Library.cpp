@@ -1,6 +1,6 @@
 #include "Library.h"
 
-int string_to_int(const string &s){
+int string_to_int(string_view s){
     int t = 0, l = s.length();
     for (int i = 0;i < l; ++i)
         t = t * 10 + s[i] - '0';
@@ -2,14 +2,16 @@
 #define TICKETSYSTEM_LIBRARY_H
 
 #include <string>
+#include <string_view>
 #include <cstring>
 #include <ostream>
 
 using std::string;
+using std::string_view;
 using std::to_string;
 using std::ostream;
 
-extern int string_to_int(const string &s); //防止 multiple definition
+extern int string_to_int(string_view s); //防止 multiple definition
 
 static int Month[3] = {30, 31, 31}; //只在这个文件里有用
 
@@ -23,11 +25,14 @@ public:
 
     TimeType(const int &x) : minute(x) {}
 
-    TimeType(const string &s) { //通过：Month-Day Hour:Minute 字符串来构造
+    TimeType(string_view s) { //通过：Month-Day Hour:Minute 字符串来构造，只有 Month-Day 时为当天 00:00
         int month = string_to_int(s.substr(0, 2));
         int day = string_to_int(s.substr(3, 2));
-        int hour = string_to_int(s.substr(6, 2));
-        int min = string_to_int(s.substr(9, 2));
+        int hour = 0, min = 0;
+        if (s.length() > 6) {
+            hour = string_to_int(s.substr(6, 2));
+            min = string_to_int(s.substr(9, 2));
+        }
 
         minute = 0;
         for (int i = 0;i < month - 6; ++i) minute += Month[i] * 1440;
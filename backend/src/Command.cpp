@@ -8,7 +8,9 @@ namespace thomas {
      }
 
      Command::Command(const Command &rhs) {
-         buffer = rhs.buffer;
+         storage = rhs.storage;
+         //指向 rhs 自己的字符串时，改为指向拷贝后的 storage
+         buffer = rhs.buffer.data() == rhs.storage.data() ? string_view(storage) : rhs.buffer;
          cur = rhs.cur;
          delimiter = rhs.delimiter;
          cnt = rhs.cnt;
@@ -18,42 +20,67 @@ namespace thomas {
          delimiter = _delimiter;
          buffer = in;
          cur = 0;//过滤行首的分隔符
-         while (buffer[cur] == delimiter) cur++;
+         while (cur < (int) buffer.length() && buffer[cur] == delimiter) cur++;
          count();
      }
 
      string Command::next_token() {
-         int j = cur, len = buffer.length();
-         string temp = "";
-         if (cur >= len) return temp;
+         return string(next_view());
+     }
 
-         while (buffer[j] != delimiter && j < len && buffer[j] != '\r') {
-             temp += buffer[j];
-             j++;
-         }
+     string_view Command::next_view() {
+         int i = cur, j = cur, len = buffer.length();
+         if (cur >= len) return string_view();
+
+         while (j < len && buffer[j] != delimiter && buffer[j] != '\r') j++;
+         string_view token(buffer.data() + i, j - i);
 
-         while (buffer[j] == delimiter && j < len && buffer[j] != '\r') j++;
+         while (j < len && buffer[j] == delimiter) j++;
          cur = j;
-         return temp;
+         return token;
+     }
+
+     void Command::parse_args() {
+         for (auto &arg : args) arg = string_view();
+         string_view opt = next_view();
+         while (!opt.empty()) {
+             string_view value = next_view();
+             if (opt.length() == 2 && opt[0] == '-' && opt[1] >= 'a' && opt[1] <= 'z')
+                 args[opt[1] - 'a'] = value;
+             opt = next_view();
+         }
+     }
+
+     string_view Command::get(char flag) const {
+         return args[flag - 'a'];
+     }
+
+     bool Splitter::next(string_view &token) {
+         if (rest.empty()) return false;
+         size_t pos = rest.find(delimiter);
+         token = rest.substr(0, pos);
+         rest = pos == string_view::npos ? string_view() : rest.substr(pos + 1);
+         return true;
      }
 
      void Command::count() {
          int len = buffer.length(), i = 0, j;
          //注意,buffer中有末尾的/r
-         while (buffer[i] == delimiter) i++;
+         while (i < len && buffer[i] == delimiter) i++;
          while (i < len && buffer[i] != '\r') {
              j = i;
-             while (buffer[j] != delimiter && j < len && buffer[j] != '\r') {
+             while (j < len && buffer[j] != delimiter && buffer[j] != '\r') {
                  j++;
              }
              if (i != j) cnt++;
-             while (buffer[j] == delimiter && j < len) j++;
+             while (j < len && buffer[j] == delimiter) j++;
              i = j;
          }
      }
 
      void Command::clear() {
-         buffer = "";
+         storage = "";
+         buffer = string_view();
          cur = 0;
          cnt = 0;
          delimiter = ' ';
@@ -61,7 +88,9 @@ namespace thomas {
      }
 
      istream &operator>>(istream &input, Command &obj) {
-         input >> obj.buffer;
+         input >> obj.storage;
+         obj.buffer = obj.storage;
+         obj.cur = 0;
          return input;
      }
 
@@ -2,10 +2,12 @@
 #define TICKETSYSTEM_COMMAND_H
 
 #include <string>
+#include <string_view>
 #include <istream>
 #include <ostream>
 
 using std::string;
+using std::string_view;
 using std::istream;
 using std::ostream;
 
@@ -16,9 +18,11 @@ namespace thomas {
         friend class TrainManagement;
 
     private:
-        string buffer = "";//存储字符串的缓冲区
+        string storage = "";//operator>> 读入的字符串，由 Command 自己持有
+        string_view buffer;//当前解析的字符串，指向构造时传入的字符串或 storage，不拷贝
         int cur = 0;//当前指针的位置
         char delimiter = ' ';//分隔符
+        string_view args[26];//parse_args 之后，-a 到 -z 的参数值，指向 buffer
 
     public:
         int cnt = 0, timestamp = 0;//时间戳
@@ -29,7 +33,7 @@ namespace thomas {
 
         Command(char _delimiter);
 
-        Command(const std::string &in, char _delimiter = ' ');
+        Command(const std::string &in, char _delimiter = ' ');//只保存 in 的视图，in 要比 Command 活得久
 
         ~Command() = default;
 
@@ -37,6 +41,12 @@ namespace thomas {
 
         string next_token();//取出下一个Token,更新cur
 
+        string_view next_view();//同上，但返回 buffer 中的视图，不分配内存
+
+        void parse_args();//把剩下的 -x value 一次解析到 args 中，拷贝后要重新解析
+
+        string_view get(char flag) const;//参数 -flag 的值，没有时为空
+
         void clear();
 
         friend istream &operator>>(istream &input, Command &obj);
@@ -46,6 +56,17 @@ namespace thomas {
         void set_delimiter(char new_delimiter); //修改分隔符
     };
 
+    class Splitter {//按分隔符切分 '|' 列表，每一段是原字符串的视图，不分配内存
+    private:
+        string_view rest;
+        char delimiter;
+
+    public:
+        Splitter(string_view s, char _delimiter = '|') : rest(s), delimiter(_delimiter) {}
+
+        bool next(string_view &token);//取出下一段，没有时返回 false
+    };
+
     //因为用 namespace，所以友元函数要在类外面声明一次
 //    istream &operator>>(istream &input, Command &obj);
 //    ostream &operator<<(ostream &os, const Command &command);
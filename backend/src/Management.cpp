@@ -47,7 +47,7 @@ void Sort(vector<T> &a, int l, int r,
     Sort(a, pl, r, cmp);
 }
 
-bool is_legal(const string &s) { //判断该日期是否合法
+bool is_legal(string_view s) { //判断该日期是否合法
   int month = string_to_int(s.substr(0, 2));
   //    int day = string_to_int(s.substr(3, 2));
   //    int hour = string_to_int(s.substr(6, 2));
@@ -58,6 +58,11 @@ bool is_legal(const string &s) { //判断该日期是否合法
   return true;
 }
 
+static void copy_view(char *dest, string_view s) { //视图不以 '\0' 结尾，要手动补上
+  memcpy(dest, s.data(), s.length());
+  dest[s.length()] = '\0';
+}
+
 //这是在外部的函数！
 //记得 train_ID 是第二关键字
 bool time_cmp(const Ticket &a, const Ticket &b) {
@@ -72,18 +77,8 @@ bool cost_cmp(const Ticket &a, const Ticket &b) {
   return a.cost() < b.cost();
 }
 
-bool order_cmp(const Order &a, const Order &b) { //按ID排序 order
-  return a.order_ID > b.order_ID;
-}
-
-bool pending_order_cmp(const PendingOrder &a,
-                       const PendingOrder &b) { //按ID排序 order
-  return a.order_ID < b.order_ID;               //越早买的越早补票
-}
-
-bool station_cmp(const std::pair<string, int> &a,
-                 const std::pair<string, int> &b) { //按名字排序
-  return a.first < b.first;
+bool order_key_cmp(const StringAny<24, int> &a, const StringAny<24, int> &b) {
+  return a.CompareBothWith(b) < 0;
 }
 
 void OUTPUT(TrainManagement &all, const string &train_ID) { //用来调试
@@ -109,7 +104,7 @@ void OUTPUT(TrainManagement &all, const string &train_ID) { //用来调试
     //            all.day_train_data.read(tp, ans[0]);
 
     for (int j = 1; j < a.station_num; ++j) {
-      cout << tp.seat_num[j] << " ";
+      cout << tp.get_seat(j) << " ";
     }
     cout << endl;
   }
@@ -123,38 +118,28 @@ void OUTPUT(TrainManagement &all, const string &train_ID) { //用来调试
 
 //----------------------------------------------class AccountManagement
 
-AccountManagement::AccountManagement() {
+AccountManagement::AccountManagement(LogManager *log_manager) {
   //    user_data.initialise("user_data");
   //    username_to_pos.init("username_to_pos");
   user_database = new BPlusTreeIndexNTS<String<24>, User, StringComparator<24>>(
-      "user_database", cmp1);
+      "user_database", cmp1, BUFFER_POOL_SIZE, false, DATABASE_REPLACER, false,
+      log_manager);
+  user_stack =
+      new StackManager<UserRecord>("user_undo.db", false, log_manager);
 }
 
 AccountManagement::AccountManagement(const string &file_name) {
   user_database = new BPlusTreeIndexNTS<String<24>, User, StringComparator<24>>(
-      file_name, cmp1);
+      file_name, cmp1, BUFFER_POOL_SIZE, false, DATABASE_REPLACER);
+  user_stack = new StackManager<UserRecord>(file_name + "_undo.db");
 }
 
 string AccountManagement::add_user(Command &line) {
   //    line.set_delimiter(' ');
-  string opt = line.next_token(), cur, username, password, name, mail;
-  int privilege;
-  while (!opt.empty()) {
-    if (opt == "-c")
-      cur = line.next_token();
-    else if (opt == "-u")
-      username = line.next_token();
-    else if (opt == "-p")
-      password = line.next_token();
-    else if (opt == "-n")
-      name = line.next_token();
-    else if (opt == "-m")
-      mail = line.next_token();
-    else
-      privilege = string_to_int(line.next_token());
-
-    opt = line.next_token();
-  }
+  line.parse_args();
+  string cur(line.get('c')), username(line.get('u')),
+      password(line.get('p')), name(line.get('n')), mail(line.get('m'));
+  int privilege = string_to_int(line.get('g'));
 
   vector<User> ans;
   user_database->SearchKey(String<24>(username), &ans);
@@ -162,6 +147,7 @@ string AccountManagement::add_user(Command &line) {
   if (user_database->IsEmpty()) { //首次添加用户
     User u(username, name, mail, password, 10);
     user_database->InsertEntry(String<24>(username), u);
+    user_stack->Push(UserRecord{ADD_USER, line.timestamp, u});
     return "0";
   } else {
     //操作失败：未登录/权限不足/用户名已存在
@@ -171,21 +157,16 @@ string AccountManagement::add_user(Command &line) {
     } else {
       User u(username, name, mail, password, privilege);
       user_database->InsertEntry(String<24>(username), u);
+      user_stack->Push(UserRecord{ADD_USER, line.timestamp, u});
       return "0";
     }
   }
 }
 
 string AccountManagement::login(Command &line) {
-  string opt = line.next_token(), username, password;
-  while (!opt.empty()) {
-    if (opt == "-u")
-      username = line.next_token();
-    else
-      password = line.next_token();
-
-    opt = line.next_token();
-  }
+  line.parse_args();
+  string username(line.get('u'));
+  string_view password = line.get('p');
 
   vector<User> ans;
   user_database->SearchKey(String<24>(username), &ans);
@@ -193,7 +174,7 @@ string AccountManagement::login(Command &line) {
   if (ans.empty() || login_pool.count(username))
     return "-1";
 
-  if (strcmp(ans[0].password, password.c_str()))
+  if (password != ans[0].password)
     return "-1"; //密码错误
 
   login_pool.insert(sjtu::pair<string, int>(username, ans[0].privilege));
@@ -201,7 +182,8 @@ string AccountManagement::login(Command &line) {
 }
 
 string AccountManagement::logout(Command &line) {
-  string opt = line.next_token(), username = line.next_token();
+  line.parse_args();
+  string username(line.get('u'));
 
   //用户未登录
   if (!login_pool.count(username))
@@ -212,24 +194,11 @@ string AccountManagement::logout(Command &line) {
 }
 
 string AccountManagement::modify_profile(Command &line) {
-  string opt = line.next_token(), cur, username, password, name, mail;
-  int privilege = 0; //记得赋初值！
-  while (!opt.empty()) {
-    if (opt == "-c")
-      cur = line.next_token();
-    else if (opt == "-u")
-      username = line.next_token();
-    else if (opt == "-p")
-      password = line.next_token();
-    else if (opt == "-n")
-      name = line.next_token();
-    else if (opt == "-m")
-      mail = line.next_token();
-    else
-      privilege = string_to_int(line.next_token());
-
-    opt = line.next_token();
-  }
+  line.parse_args();
+  string cur(line.get('c')), username(line.get('u'));
+  string_view password = line.get('p'), name = line.get('n'),
+              mail = line.get('m');
+  int privilege = string_to_int(line.get('g')); //没有 -g 时为 0
 
   vector<User> ans;
   user_database->SearchKey(String<24>(username), &ans);
@@ -244,31 +213,25 @@ string AccountManagement::modify_profile(Command &line) {
     return "-1";
 
   if (!password.empty())
-    strcpy(u.password, password.c_str());
+    copy_view(u.password, password);
   if (!name.empty())
-    strcpy(u.name, name.c_str());
+    copy_view(u.name, name);
   if (!mail.empty())
-    strcpy(u.mail_addr, mail.c_str());
+    copy_view(u.mail_addr, mail);
   if (privilege)
     u.privilege = privilege;
 
   //    user_data.update(u, ans[0]);
   user_database->InsertEntry(String<24>(username), u);
+  user_stack->Push(UserRecord{MODIFY_PROFILE, line.timestamp, ans[0]});
 
   return (string)u.user_name + " " + (string)u.name + " " +
          (string)u.mail_addr + " " + to_string(u.privilege);
 }
 
 string AccountManagement::query_profile(Command &line) {
-  string opt = line.next_token(), cur, username, password, name, mail;
-  while (!opt.empty()) {
-    if (opt == "-c")
-      cur = line.next_token();
-    else
-      username = line.next_token();
-
-    opt = line.next_token();
-  }
+  line.parse_args();
+  string cur(line.get('c')), username(line.get('u'));
 
   vector<User> ans;
   user_database->SearchKey(String<24>(username), &ans);
@@ -285,30 +248,75 @@ string AccountManagement::query_profile(Command &line) {
          (string)u.mail_addr + " " + to_string(u.privilege);
 }
 
-AccountManagement::~AccountManagement() { delete user_database; }
+void AccountManagement::rollback(int timestamp) {
+  //同一个用户只写回最早的那条记录对应的值
+  WriteBatch<BPlusTreeIndexNTS<String<24>, User, StringComparator<24>>,
+             String<24>, User, KeyLess<String<24>, StringComparator<24>>>
+      users(user_database);
+  UserRecord record;
+  while (!user_stack->IsEmpty()) {
+    user_stack->Top(record);
+    if (record.timestamp <= timestamp)
+      break;
+    user_stack->Pop(record);
+    if (record.type == ADD_USER)
+      users.erase(String<24>(record.user.user_name));
+    else
+      users.put(String<24>(record.user.user_name), record.user);
+  }
+  users.flush(); //弹出的记录和索引的修改一起提交
+  login_pool.clear();
+}
+
+AccountManagement::~AccountManagement() {
+  delete user_database;
+  delete user_stack;
+}
 
 //-------------------------------------------------class TrainManagement
 
-TrainManagement::TrainManagement() : cmp2(2), cmp3(3), cmp4(3), cmp5(2) {
+TrainManagement::TrainManagement(LogManager *log_manager)
+    : cmp2(2), cmp3(3), cmp4(3), cmp5(2) {
   //先指定 cmp 的类型
 
   train_database =
-      new BPlusTreeIndexNTS<String<24>, Train, StringComparator<24>>(
-          "train_database", cmp1);
+      new BPlusTreeHeapIndexNTS<String<24>, Train, StringComparator<24>>(
+          "train_database", cmp1, BUFFER_POOL_SIZE, false, DATABASE_REPLACER,
+          true, // 查询和购票都要按车次找车，内部节点常驻并直接用指针下降
+          log_manager);
   station_database = new BPlusTreeIndexNTS<DualString<32, 24>, Station,
                                            DualStringComparator<32, 24>>(
-      "station_database", cmp2);
+      "station_database", cmp2, BUFFER_POOL_SIZE, false, DATABASE_REPLACER,
+      false, log_manager);
   daytrain_database = new BPlusTreeIndexNTS<StringAny<24, int>, DayTrain,
                                             StringAnyComparator<24, int>>(
-      "daytrain_database", cmp3);
-  order_database = new BPlusTreeIndexNTS<StringAny<24, int>, Order,
-                                         StringAnyComparator<24, int>>(
-      "order_database", cmp4);
+      "daytrain_database", cmp3, BUFFER_POOL_SIZE, false, DATABASE_REPLACER,
+      false, log_manager);
+  order_database = new BPlusTreeHeapIndexNTS<StringAny<24, int>, Order,
+                                             StringAnyComparator<24, int>>(
+      "order_database", cmp4, BUFFER_POOL_SIZE, false, DATABASE_REPLACER,
+      false, log_manager);
   pending_order_database = new BPlusTreeIndexNTS<StringIntInt<24>, PendingOrder,
                                                  StringIntIntComparator<24>>(
-      "pending_order_database", cmp5);
+      "pending_order_database", cmp5, BUFFER_POOL_SIZE, false,
+      DATABASE_REPLACER, false, log_manager);
+  station_id_database =
+      new BPlusTreeIndexNTS<String<32>, int, StringComparator<32>>(
+          "station_id_database", cmp6, BUFFER_POOL_SIZE, false,
+          DATABASE_REPLACER, false, log_manager);
+  route_database =
+      new BPlusTreeIndexNTS<String<24>, TrainRoute, StringComparator<24>>(
+          "route_database", cmp1, BUFFER_POOL_SIZE, false, DATABASE_REPLACER,
+          false, log_manager);
 
   order_num = order_database->Size();
+  station_id_num = station_id_database->Size();
+
+  //撤销记录和索引在同一次提交中写入，崩溃后两者一致
+  undo_stack =
+      new StackManager<TrainRecord>("train_undo.db", false, log_manager);
+  deleted_trains =
+      new StackManager<Train>("deleted_train.db", false, log_manager);
 }
 
 TrainManagement::~TrainManagement() {
@@ -317,52 +325,44 @@ TrainManagement::~TrainManagement() {
   delete daytrain_database;
   delete order_database;
   delete pending_order_database;
+  delete station_id_database;
+  delete route_database;
+  delete undo_stack;
+  delete deleted_trains;
 }
 
-string TrainManagement::add_train(Command &line) {
-  string opt = line.next_token(), train_id, stations, prices, type;
-  string start_time, travel_times, stop_over_times, sale_date;
-  int seat_num = 0, station_num = 0;
-
-  while (!opt.empty()) {
-    if (opt == "-i")
-      train_id = line.next_token();
-    else if (opt == "-n")
-      station_num = string_to_int(line.next_token());
-    else if (opt == "-m")
-      seat_num = string_to_int(line.next_token());
-    else if (opt == "-s")
-      stations = line.next_token();
-    else if (opt == "-p")
-      prices = line.next_token();
-    else if (opt == "-x")
-      start_time = line.next_token();
-    else if (opt == "-t")
-      travel_times = line.next_token();
-    else if (opt == "-o")
-      stop_over_times = line.next_token();
-    else if (opt == "-d")
-      sale_date = line.next_token();
-    else
-      type = line.next_token();
+void TrainManagement::push_record(int type, int timestamp, const string &id,
+                                  int pos, Status status) {
+  TrainRecord record;
+  record.type = type, record.timestamp = timestamp;
+  strcpy(record.id, id.c_str());
+  record.pos = pos, record.status = status;
+  undo_stack->Push(record);
+}
 
-    opt = line.next_token();
-  }
+string TrainManagement::add_train(Command &line) {
+  //参数都是命令中的视图，'|' 列表在 Train 的构造函数中切分
+  line.parse_args();
+  string train_id(line.get('i'));
+  int station_num = string_to_int(line.get('n')),
+      seat_num = string_to_int(line.get('m'));
 
   vector<Train> ans;
   train_database->SearchKey(String<24>(train_id), &ans);
   if (!ans.empty())
     return "-1"; // train_ID 已存在，添加失败
 
-  Train new_train(train_id, station_num, seat_num, stations, prices, start_time,
-                  travel_times, stop_over_times, sale_date, type);
+  Train new_train(train_id, station_num, seat_num, line.get('s'), line.get('p'),
+                  line.get('x'), line.get('t'), line.get('o'), line.get('d'),
+                  line.get('y'));
   train_database->InsertEntry(String<24>(train_id), new_train);
+  push_record(ADD_TRAIN, line.timestamp, train_id);
   return "0";
 }
 
 string TrainManagement::release_train(Command &line) {
-  line.next_token(); //过滤-i
-  string t_id = line.next_token();
+  line.parse_args();
+  string t_id(line.get('i'));
 
   vector<Train> ans;
   train_database->SearchKey(String<24>(t_id), &ans);
@@ -371,50 +371,50 @@ string TrainManagement::release_train(Command &line) {
   Train target_train = ans[0];
   if (target_train.is_released)
     return "-1"; //重复发布，失败
+  push_record(RELEASE_TRAIN, line.timestamp, t_id, station_id_num);
   target_train.is_released = true;
   train_database->InsertEntry(String<24>(t_id), target_train);
 
-  //维护 每天的车次座位数
+  //维护 每天的车次座位数，同一车次的日期是有序的键，整批装入
+  DayTrain tp_daytrain(target_train.station_num, target_train.total_seat_num);
+  vector<std::pair<StringAny<24, int>, DayTrain>> daytrains;
   for (auto i = target_train.start_sale_date; i <= target_train.end_sale_date;
        i += 1440) {
-    DayTrain tp_daytrain; // todo: 可能要开在外面，不然会炸
-    for (int j = 1; j <= target_train.station_num; ++j)
-      tp_daytrain.seat_num[j] = target_train.total_seat_num;
-
     //目前直接用 train_id + time 替代
-    daytrain_database->InsertEntry(StringAny<24, int>(t_id, i.get_value()),
-                                   tp_daytrain);
+    daytrains.push_back(
+        std::make_pair(StringAny<24, int>(t_id, i.get_value()), tp_daytrain));
   }
+  if (!daytrains.empty())
+    daytrain_database->BulkLoad(&daytrains[0],
+                                &daytrains[0] + daytrains.size());
 
   //维护 沿途的每个车站
+  int ids[maxn];
   for (int i = 1; i <= target_train.station_num; ++i) {
-    Station tp_station(
-        t_id, target_train.stations[i], target_train.price_sum[i],
-        target_train.start_sale_date, target_train.end_sale_date,
-        target_train.arriving_times[i], target_train.leaving_times[i], i);
+    ids[i] = get_station_id(target_train.stations[i]);
+    Station tp_station(t_id, target_train.price_sum[i],
+                       target_train.start_sale_date, target_train.end_sale_date,
+                       target_train.arriving_times[i],
+                       target_train.leaving_times[i], i);
     //同理，目前直接用 train_id + station_name 替代
     station_database->InsertEntry(
         DualString<32, 24>(target_train.stations[i], t_id), tp_station);
+    station_cache.add(target_train.stations[i], tp_station);
   }
+  route_database->InsertEntry(String<24>(t_id), TrainRoute(target_train, ids));
 
   return "0";
 }
 
 string TrainManagement::query_train(Command &line) {
-  string opt = line.next_token(), t_id, date, output;
-  while (!opt.empty()) {
-    if (opt == "-i")
-      t_id = line.next_token();
-    else
-      date = line.next_token();
-
-    opt = line.next_token();
-  }
-  if (!is_legal(date + " 00:00"))
+  line.parse_args();
+  string t_id(line.get('i')), output;
+  string_view date = line.get('d');
+  if (!is_legal(date))
     return "-1"; //查询，要判断读入的日期是否合法
 
   vector<Train> ans;
-  TimeType day(date + " 00:00");
+  TimeType day(date);
   train_database->SearchKey(String<24>(t_id), &ans);
   if (ans.empty())
     return "-1"; //没有车
@@ -455,13 +455,13 @@ string TrainManagement::query_train(Command &line) {
     //从 current_daytrain 获取实时的座位数
     output += string(target_train.stations[1]) + " xx-xx xx:xx -> " +
               (day + target_train.start_time).transfer() + " 0 " +
-              to_string(current_daytrain.seat_num[1]) + "\n";
+              to_string(current_daytrain.get_seat(1)) + "\n";
     for (int i = 2; i <= target_train.station_num - 1; ++i) {
       output += string(target_train.stations[i]) + " " +
                 (day + target_train.arriving_times[i]).transfer() + " -> " +
                 (day + target_train.leaving_times[i]).transfer() + " " +
                 to_string(target_train.price_sum[i]) + " " +
-                to_string(current_daytrain.seat_num[i]) + "\n";
+                to_string(current_daytrain.get_seat(i)) + "\n";
     }
     output += string(target_train.stations[target_train.station_num]) + " " +
               (day + target_train.arriving_times[target_train.station_num])
@@ -474,8 +474,8 @@ string TrainManagement::query_train(Command &line) {
 }
 
 string TrainManagement::delete_train(Command &line) {
-  line.next_token();
-  string t_id = line.next_token();
+  line.parse_args();
+  string t_id(line.get('i'));
   vector<Train> ans;
   train_database->SearchKey(String<24>(t_id), &ans);
   if (ans.empty())
@@ -486,48 +486,79 @@ string TrainManagement::delete_train(Command &line) {
     return "-1"; //已发布，不能删
 
   train_database->DeleteEntry(String<24>(t_id));
+  deleted_trains->Push(target_train);
+  push_record(DELETE_TRAIN, line.timestamp, t_id);
   return "0";
 }
 
+vector<Station> *TrainManagement::get_stations(const string &station_name) {
+  vector<Station> *list = station_cache.find(station_name);
+  if (list != nullptr)
+    return list;
+
+  //未缓存，从 station_database 中读出该站的所有车次（已按 train_ID 排序）
+  //关键字是 (车站, train_ID)，上界的 train_ID 用全 0xff 填满
+  vector<Station> ans;
+  station_database->Scan(
+      DualString<32, 24>(station_name, ""),
+      DualString<32, 24>(station_name, string(24, '\xff')),
+      [&](const DualString<32, 24> &, const Station &station) {
+        ans.push_back(station);
+        return true;
+      });
+  return station_cache.insert(station_name, ans);
+}
+
+int TrainManagement::get_station_id(const string &station_name) {
+  vector<int> ans;
+  station_id_database->SearchKey(String<32>(station_name), &ans);
+  if (!ans.empty())
+    return ans[0];
+  station_id_database->InsertEntry(String<32>(station_name), station_id_num);
+  return station_id_num++;
+}
+
+int TrainManagement::count_orders(const string &user_name) {
+  //订单的位置从 1 开始连续编号，最新一个订单的位置就是订单数，倒着读一个关键字即可
+  int cnt = 0;
+  order_database->ReverseScanKeys(
+      StringAny<24, int>(user_name, 0), StringAny<24, int>(user_name, MAX_INT),
+      [&](const StringAny<24, int> &key) {
+        cnt = key.GetAny();
+        return false;
+      });
+  return cnt;
+}
+
 string TrainManagement::query_ticket(Command &line) {
-  string opt = line.next_token(), s, t, date, type = "time"; //默认按时间排序
-  while (!opt.empty()) {
-    if (opt == "-s")
-      s = line.next_token();
-    else if (opt == "-t")
-      t = line.next_token();
-    else if (opt == "-d")
-      date = line.next_token();
-    else if (opt == "-p")
-      type = line.next_token();
-
-    opt = line.next_token();
-  }
-  if (!is_legal(date + " 00:00"))
+  line.parse_args();
+  string s(line.get('s')), t(line.get('t'));
+  string_view date = line.get('d'), type = line.get('p');
+  if (type.empty())
+    type = "time"; //默认按时间排序
+  if (!is_legal(date))
     return "0"; //查询，要判断读入的日期是否合法
 
   if (s == t)
     return "0"; //起点等于终点，显然无票
-  TimeType day(date + " 00:00");
-  vector<Station> ans1, ans2;
-
-  DualStringComparator<32, 24> tp_cmp(1);
-  // todo:区间查找，查找所有 站点为 s 和 t 的 station 车站
-  station_database->ScanKey(DualString<32, 24>(s, ""), &ans1, tp_cmp);
-  station_database->ScanKey(DualString<32, 24>(t, ""), &ans2, tp_cmp);
+  TimeType day(date);
+  //两个列表都在缓存中，按 train_ID 有序，直接归并，不需要拷贝
+  station_cache.trim();
+  vector<Station> &ans1 = *get_stations(s);
+  vector<Station> &ans2 = *get_stations(t);
 
   if (ans1.empty() || ans2.empty())
     return "0"; //无票
   int cnt = 0;
-  Station s1, t1; //起点和终点
 
   vector<Ticket> tickets;
-  for (int i1 = 0, i2 = 0; i1 < ans1.size() && i2 < ans2.size();) {
-    s1 = ans1[i1], t1 = ans2[i2];
+  for (size_t i1 = 0, i2 = 0; i1 < ans1.size() && i2 < ans2.size();) {
+    const Station &s1 = ans1[i1], &t1 = ans2[i2]; //起点和终点
     //判断是否为同一辆车
-    if (strcmp(s1.train_ID, t1.train_ID) < 0)
+    int res = strcmp(s1.train_ID, t1.train_ID);
+    if (res < 0)
       i1++;
-    else if (strcmp(s1.train_ID, t1.train_ID) > 0)
+    else if (res > 0)
       i2++;
     else if (s1.index >= t1.index) { //同一辆车，但是 s1 应该在 t1 之后
       i1++, i2++; // 注意到，一列火车只会经过站点一次
@@ -539,7 +570,9 @@ string TrainManagement::query_ticket(Command &line) {
       //也就是从第一站出发的日期
       if (s1.start_sale_time <= start_day &&
           start_day <= s1.end_sale_time) { //能买到
-        tickets.push_back(Ticket(s1, t1));
+        Ticket ticket(s1, t1);
+        ticket.start_day = start_day;
+        tickets.push_back(ticket);
       }
       i1++, i2++;
     }
@@ -548,6 +581,18 @@ string TrainManagement::query_ticket(Command &line) {
   if (!cnt)
     return "0"; //无符合条件的车票
 
+  //此时 tickets 按 train_ID 有序，和 daytrain_database 的关键字顺序一致，
+  //在排序前整批查询余票，相邻的查询共用一次下降和同一个叶子
+  vector<StringAny<24, int>> day_keys;
+  for (int i = 0; i <= cnt - 1; ++i)
+    day_keys.push_back(StringAny<24, int>(tickets[i].s.train_ID,
+                                          tickets[i].start_day.get_value()));
+  vector<DayTrain> days;
+  daytrain_database->MultiGet(day_keys, &days);
+  for (int i = 0; i <= cnt - 1; ++i)
+    tickets[i].seat = days[i].query_seat(
+        tickets[i].s.index, tickets[i].t.index - 1); //终点站的座位数不影响
+
   if (type == "time")
     Sort(tickets, 0, cnt - 1, time_cmp);
   else
@@ -555,223 +600,167 @@ string TrainManagement::query_ticket(Command &line) {
 
   string output = to_string(cnt);
   for (int i = 0; i <= cnt - 1; ++i) {
-    TimeType start_day = day - tickets[i].s.leaving_time.get_date();
-    vector<DayTrain> all;
-    daytrain_database->SearchKey(
-        StringAny<24, int>(tickets[i].s.train_ID, start_day.get_value()), &all);
-    DayTrain tp_daytrain = all[0];
-
-    string seat = to_string(tp_daytrain.query_seat(
-        tickets[i].s.index, tickets[i].t.index - 1)); //终点站的座位数不影响
-
-    output += "\n" + string(tickets[i].s.train_ID) + " " +
-              string(tickets[i].s.station_name) + " " +
-              (start_day + tickets[i].s.leaving_time).transfer() + " -> " +
-              string(tickets[i].t.station_name) + " " +
-              (start_day + tickets[i].t.arriving_time).transfer() + " " +
-              to_string(tickets[i].cost()) + " " + seat;
+    TimeType start_day = tickets[i].start_day;
+    output += "\n" + string(tickets[i].s.train_ID) + " " + s + " " +
+              (start_day + tickets[i].s.leaving_time).transfer() + " -> " + t +
+              " " + (start_day + tickets[i].t.arriving_time).transfer() + " " +
+              to_string(tickets[i].cost()) + " " + to_string(tickets[i].seat);
   }
 
   return output;
 }
 
 string TrainManagement::query_transfer(Command &line) {
-  string opt = line.next_token(), s, t, date, type = "time",
-         output; //默认按时间排序
-  while (!opt.empty()) {
-    if (opt == "-s")
-      s = line.next_token();
-    else if (opt == "-t")
-      t = line.next_token();
-    else if (opt == "-d")
-      date = line.next_token();
-    else if (opt == "-p")
-      type = line.next_token();
-
-    opt = line.next_token();
-  }
-  if (!is_legal(date + " 00:00"))
+  line.parse_args();
+  string s(line.get('s')), t(line.get('t'));
+  string_view date = line.get('d'), type = line.get('p');
+  string output;
+  if (type.empty())
+    type = "time"; //默认按时间排序
+  if (!is_legal(date))
     return "0"; //查询，要判断读入的日期是否合法
   if (s == t)
     return "0"; //起点和终点相同
-  TimeType day(date + " 00:00");
-  int COST = MAX_INT, TIME = MAX_INT, FIRST_TIME = MAX_INT; //用来比较答案
-  //总花费，总时间，第一段列车的运行时间（越小表示 Train1_ID 也越小）
+  TimeType day(date);
 
-  DualStringComparator<32, 24> tp_cmp(1);
-  // todo:区间查找，查找所有 站点为 s 和 t 的 station 车站
-  vector<Station> ans1, ans2;
-  station_database->ScanKey(DualString<32, 24>(s, ""), &ans1, tp_cmp);
-  station_database->ScanKey(DualString<32, 24>(t, ""), &ans2, tp_cmp);
+  station_cache.trim();
+  vector<Station> &ans1 = *get_stations(s);
+  vector<Station> &ans2 = *get_stations(t);
 
   if (ans1.empty() || ans2.empty())
     return "0"; //无票
-  int cnt = 0;
-  Station s1, t1; //起点，终点
 
-  for (int i = 0; i < ans1.size(); ++i) { //枚举经过起点s1的不同车次
-    s1 = ans1[i];
-    TimeType start_day1 = day - s1.leaving_time.get_date();
-    if (start_day1 < s1.start_sale_time || start_day1 > s1.end_sale_time)
+  //第一段：经过起点、当天能买到票的车次，车站列表按 train_ID 有序，整批查询
+  vector<int> firsts;
+  vector<String<24>> route_keys1;
+  for (size_t i = 0; i < ans1.size(); ++i) {
+    TimeType start_day1 = day - ans1[i].leaving_time.get_date();
+    if (start_day1 < ans1[i].start_sale_time ||
+        start_day1 > ans1[i].end_sale_time)
       continue; //买不到票
+    firsts.push_back(i);
+    route_keys1.push_back(String<24>(ans1[i].train_ID));
+  }
+  if (firsts.empty())
+    return "0";
+  vector<TrainRoute> routes1;
+  route_database->MultiGet(route_keys1, &routes1);
+
+  //第二段：把经过终点的车次在终点之前的每一站，按车站编号挂到桶里
+  while (transfer_head.size() < (size_t)station_id_num)
+    transfer_head.push_back(-1);
+  vector<String<24>> route_keys2;
+  for (size_t j = 0; j < ans2.size(); ++j)
+    route_keys2.push_back(String<24>(ans2[j].train_ID));
+  vector<TrainRoute> routes2;
+  route_database->MultiGet(route_keys2, &routes2);
+  vector<int> leg_train, leg_index, leg_next; //桶中的链表
+  for (size_t j = 0; j < ans2.size(); ++j) {
+    for (int l = 1; l < ans2[j].index; ++l) {
+      int id = routes2[j].station_ids[l];
+      leg_train.push_back(j), leg_index.push_back(l);
+      leg_next.push_back(transfer_head[id]);
+      transfer_head[id] = leg_next.size() - 1;
+    }
+  }
+
+  //用第一段之后的每一站去探测桶，只枚举真正相遇的 (车次1, 车次2, 中转站)
+  //答案按 (第一关键字, 第二关键字, 第一段时间, train1_ID, train2_ID) 取最小
+  int KEY1 = MAX_INT, KEY2 = MAX_INT, FIRST_TIME = MAX_INT;
+  int best_i = -1, best_j = -1, best_k = 0, best_l = 0;
+  TimeType best_day1, best_day2;
+  for (size_t x = 0; x < firsts.size(); ++x) {
+    const Station &s1 = ans1[firsts[x]];
+    const TrainRoute &train1 = routes1[x];
+    TimeType start_day1 = day - s1.leaving_time.get_date();
 
-    vector<Train> all;
-    train_database->SearchKey(String<24>(s1.train_ID), &all);
-    Train train1 = all[0];
-
-    for (int j = 0; j < ans2.size(); ++j) { //枚举经过终点t1的不同车次
-      t1 = ans2[j];
-      if (!strcmp(s1.train_ID, t1.train_ID))
-        continue; //换乘要求不同车次
-
-      vector<Train> pos2;
-      train_database->SearchKey(String<24>(t1.train_ID), &pos2);
-      Train train2 = pos2[0]; //到达的车次
-
-      //把可能途径的车站全部读取出来，方便查询
-      //注意循环的范围
-      int cnt1 = 0, cnt2 = 0;
-      vector<std::pair<string, int>> starts, ends;
-      for (int k = s1.index + 1; k <= train1.station_num; ++k)
-        starts.push_back(std::make_pair(train1.stations[k], k));
-      for (int k = 1; k < t1.index; ++k)
-        ends.push_back(std::make_pair(train2.stations[k], k));
-      cnt1 = starts.size(), cnt2 = ends.size();
-      if (!cnt1 || !cnt2)
-        continue;
-
-      // todo: 或许可以删掉？因为已经按照 station_name 排序
-      Sort(starts, 0, cnt1 - 1, station_cmp);
-      Sort(ends, 0, cnt2 - 1, station_cmp); //先按车站名称排序，可以加快查找
-
-      //枚举中转站
-      for (int i1 = 0, i2 = 0; i1 < cnt1 && i2 < cnt2;) {
-        if (starts[i1].first < ends[i2].first)
-          i1++; //找到相同的一站
-        else if (starts[i1].first > ends[i2].first)
-          i2++;
-        else {
-          int k = starts[i1].second, l = ends[i2].second; //找到中转站
-          i1++, i2++;
-
-          TimeType fast_start_day2; // train2的最快发车日期
-          //保证第二辆车的上车时间，为第一辆车到达当天
-          if (train1.arriving_times[k].get_time() <=
-              train2.leaving_times[l].get_time()) //当天能赶上
-            fast_start_day2 = start_day1 + train1.arriving_times[k].get_date() -
-                              train2.leaving_times[l].get_date();
-          else //赶不上，多等一天
-            fast_start_day2 = start_day1 + train1.arriving_times[k].get_date() -
-                              train2.leaving_times[l].get_date() + 1440;
-
-          if (t1.end_sale_time < fast_start_day2)
-            continue; //赶不上买票
-          TimeType start_day2 = std::max(
-              fast_start_day2, t1.start_sale_time); //真正的日期，发车且发售
-          bool updated = false;
-
-          //按照关键字更新答案
-          if (type == "cost") {
-            if ( //第一关键字cost
-                (COST > train1.price_sum[k] - s1.price_sum + t1.price_sum -
-                            train2.price_sum[l]) ||
-                //第二关键字time
-                ((COST == train1.price_sum[k] - s1.price_sum + t1.price_sum -
-                              train2.price_sum[l]) &&
-                 (TIME > (start_day2 + t1.arriving_time) -
-                             (start_day1 + s1.leaving_time))) ||
-                //第三关键字 train1_ID
-                ((COST == train1.price_sum[k] - s1.price_sum + t1.price_sum -
-                              train2.price_sum[l]) &&
-                 (TIME == (start_day2 + t1.arriving_time) -
-                              (start_day1 + s1.leaving_time)) &&
-                 (FIRST_TIME > (train1.arriving_times[k] - s1.leaving_time)))) {
-              COST = train1.price_sum[k] - s1.price_sum + t1.price_sum -
-                     train2.price_sum[l];
-              TIME = (start_day2 + t1.arriving_time) -
-                     (start_day1 + s1.leaving_time);
-              FIRST_TIME = (train1.arriving_times[k] - s1.leaving_time);
-              updated = true;
-            }
-          } else {
-            if ( //第一关键字time
-                (TIME > (start_day2 + t1.arriving_time) -
-                            (start_day1 + s1.leaving_time)) ||
-                //第二关键字cost
-                ((TIME == (start_day2 + t1.arriving_time) -
-                              (start_day1 + s1.leaving_time)) &&
-                 (COST > train1.price_sum[k] - s1.price_sum + t1.price_sum -
-                             train2.price_sum[l])) ||
-                //第三关键字 train1_ID
-                ((COST == train1.price_sum[k] - s1.price_sum + t1.price_sum -
-                              train2.price_sum[l]) &&
-                 (TIME == (start_day2 + t1.arriving_time) -
-                              (start_day1 + s1.leaving_time)) &&
-                 (FIRST_TIME > (train1.arriving_times[k] - s1.leaving_time)))) {
-              COST = train1.price_sum[k] - s1.price_sum + t1.price_sum -
-                     train2.price_sum[l];
-              TIME = (start_day2 + t1.arriving_time) -
-                     (start_day1 + s1.leaving_time);
-              FIRST_TIME = (train1.arriving_times[k] - s1.leaving_time);
-              updated = true;
-            }
-          }
-          if (updated) { //如果更新答案，就保存结果
-            output.clear();
-            vector<DayTrain> f1, f2;
-            daytrain_database->SearchKey(
-                StringAny<24, int>(train1.train_ID, start_day1.get_value()),
-                &f1);
-            daytrain_database->SearchKey(
-                StringAny<24, int>(train2.train_ID, start_day2.get_value()),
-                &f2);
-            DayTrain S = f1[0], T = f2[0]; //读出当前的座位
-
-            output += string(s1.train_ID) + " " + string(s1.station_name) +
-                      " " + (start_day1 + s1.leaving_time).transfer() + " -> " +
-                      string(train1.stations[k]) + " " +
-                      (start_day1 + train1.arriving_times[k]).transfer() + " " +
-                      to_string(train1.price_sum[k] - s1.price_sum) + " " +
-                      to_string(S.query_seat(s1.index, k - 1)) + "\n";
-            output += string(t1.train_ID) + " " + string(train2.stations[l]) +
-                      " " + (start_day2 + train2.leaving_times[l]).transfer() +
-                      " -> " + string(t1.station_name) + " " +
-                      (start_day2 + t1.arriving_time).transfer() + " " +
-                      to_string(t1.price_sum - train2.price_sum[l]) + " " +
-                      to_string(T.query_seat(l, t1.index - 1));
-          }
+    for (int k = s1.index + 1; k <= train1.station_num; ++k) {
+      for (int e = transfer_head[train1.station_ids[k]]; e != -1;
+           e = leg_next[e]) {
+        int j = leg_train[e], l = leg_index[e];
+        const Station &t1 = ans2[j];
+        const TrainRoute &train2 = routes2[j];
+        if (!strcmp(s1.train_ID, t1.train_ID))
+          continue; //换乘要求不同车次
+
+        TimeType fast_start_day2; // train2的最快发车日期
+        //保证第二辆车的上车时间，为第一辆车到达当天
+        if (train1.arriving_times[k].get_time() <=
+            train2.leaving_times[l].get_time()) //当天能赶上
+          fast_start_day2 = start_day1 + train1.arriving_times[k].get_date() -
+                            train2.leaving_times[l].get_date();
+        else //赶不上，多等一天
+          fast_start_day2 = start_day1 + train1.arriving_times[k].get_date() -
+                            train2.leaving_times[l].get_date() + 1440;
+
+        if (t1.end_sale_time < fast_start_day2)
+          continue; //赶不上买票
+        TimeType start_day2 = std::max(
+            fast_start_day2, t1.start_sale_time); //真正的日期，发车且发售
+
+        int cost = train1.price_sum[k] - s1.price_sum + t1.price_sum -
+                   train2.price_sum[l];
+        int time =
+            (start_day2 + t1.arriving_time) - (start_day1 + s1.leaving_time);
+        int first_time = train1.arriving_times[k] - s1.leaving_time;
+        int key1 = type == "cost" ? cost : time,
+            key2 = type == "cost" ? time : cost;
+
+        //按照关键字更新答案，firsts 按 train1_ID 递增枚举
+        if (key1 < KEY1 || (key1 == KEY1 && key2 < KEY2) ||
+            (key1 == KEY1 && key2 == KEY2 && first_time < FIRST_TIME) ||
+            (key1 == KEY1 && key2 == KEY2 && first_time == FIRST_TIME &&
+             firsts[x] == best_i && j < best_j)) {
+          KEY1 = key1, KEY2 = key2, FIRST_TIME = first_time;
+          best_i = firsts[x], best_j = j, best_k = k, best_l = l;
+          best_day1 = start_day1, best_day2 = start_day2;
         }
       }
     }
   }
-  if (FIRST_TIME != MAX_INT)
-    return output;
-  return "0";
+
+  //清空用过的桶，下一次查询不用整体重置
+  for (size_t e = 0; e < leg_train.size(); ++e)
+    transfer_head[routes2[leg_train[e]].station_ids[leg_index[e]]] = -1;
+
+  if (best_i == -1)
+    return "0";
+
+  const Station &s1 = ans1[best_i], &t1 = ans2[best_j];
+  vector<Train> all;
+  train_database->SearchKey(String<24>(s1.train_ID), &all);
+  const Train &train1 = all[0]; //只为输出中转站的名字读一次
+  vector<TrainRoute> pos2;
+  route_database->SearchKey(String<24>(t1.train_ID), &pos2);
+  const TrainRoute &train2 = pos2[0];
+
+  vector<DayTrain> f1, f2;
+  daytrain_database->SearchKey(
+      StringAny<24, int>(s1.train_ID, best_day1.get_value()), &f1);
+  daytrain_database->SearchKey(
+      StringAny<24, int>(t1.train_ID, best_day2.get_value()), &f2);
+  DayTrain S = f1[0], T = f2[0]; //读出当前的座位
+
+  int k = best_k, l = best_l;
+  output += string(s1.train_ID) + " " + s + " " +
+            (best_day1 + s1.leaving_time).transfer() + " -> " +
+            string(train1.stations[k]) + " " +
+            (best_day1 + train1.arriving_times[k]).transfer() + " " +
+            to_string(train1.price_sum[k] - s1.price_sum) + " " +
+            to_string(S.query_seat(s1.index, k - 1)) + "\n";
+  output += string(t1.train_ID) + " " + string(train1.stations[k]) + " " +
+            (best_day2 + train2.leaving_times[l]).transfer() + " -> " + t +
+            " " + (best_day2 + t1.arriving_time).transfer() + " " +
+            to_string(t1.price_sum - train2.price_sum[l]) + " " +
+            to_string(T.query_seat(l, t1.index - 1));
+  return output;
 }
 
 string TrainManagement::buy_ticket(Command &line, AccountManagement &accounts) {
-  string opt = line.next_token(), user_name, train_ID, S, T, date;
-  int num, is_pending = 0;
-  while (!opt.empty()) {
-    if (opt == "-u")
-      user_name = line.next_token();
-    else if (opt == "-i")
-      train_ID = line.next_token();
-    else if (opt == "-d")
-      date = line.next_token();
-    else if (opt == "-n")
-      num = string_to_int(line.next_token());
-    else if (opt == "-f")
-      S = line.next_token();
-    else if (opt == "-t")
-      T = line.next_token();
-    else if (opt == "-q") {
-      if (line.next_token() == "true")
-        is_pending = 1;
-    }
-
-    opt = line.next_token();
-  }
+  line.parse_args();
+  string user_name(line.get('u')), train_ID(line.get('i'));
+  string_view S = line.get('f'), T = line.get('t'), date = line.get('d');
+  int num = string_to_int(line.get('n')), is_pending = line.get('q') == "true";
 
   if (!accounts.login_pool.count(user_name))
     return "-1"; //用户未登录
@@ -790,16 +779,16 @@ string TrainManagement::buy_ticket(Command &line, AccountManagement &accounts) {
   int s = 0, t = 0;
   for (int i = 1; i <= target_train.station_num && !(s && t);
        ++i) { //求出station index
-    if (!strcmp(target_train.stations[i], S.c_str()))
+    if (S == target_train.stations[i])
       s = i;
-    if (!strcmp(target_train.stations[i], T.c_str()))
+    if (T == target_train.stations[i])
       t = i;
   }
   if (!s || !t || s >= t)
     return "-1"; //车站不合要求
 
   TimeType start_day =
-      TimeType(date + " 00:00") - target_train.leaving_times[s].get_date();
+      TimeType(date) - target_train.leaving_times[s].get_date();
   if (start_day < target_train.start_sale_date ||
       start_day > target_train.end_sale_date)
     return "-1"; //不在售票日期
@@ -826,11 +815,15 @@ string TrainManagement::buy_ticket(Command &line, AccountManagement &accounts) {
                   target_train.stations[t]);
   //    strcpy(new_order.id, (user_name + to_string(order_ID)).c_str());
 
+  //订单按该用户的第几个订单存放，第 x 新的订单可以直接按位置找到
+  new_order.pos = count_orders(user_name) + 1;
+  push_record(BUY_TICKET, line.timestamp, user_name, new_order.pos);
+
   if (remain_seat >= num) { //座位足够
     tp.modify_seat(s, t - 1, -num);
     daytrain_database->InsertEntry(
         StringAny<24, int>(train_ID, start_day.get_value()), tp);
-    order_database->InsertEntry(StringAny<24, int>(user_name, order_ID),
+    order_database->InsertEntry(StringAny<24, int>(user_name, new_order.pos),
                                 new_order);
     long long total = num * price;
     return to_string(total);
@@ -838,8 +831,9 @@ string TrainManagement::buy_ticket(Command &line, AccountManagement &accounts) {
     new_order.status = pending;
     PendingOrder pending_order(train_ID, user_name, start_day, num, s, t,
                                order_ID);
+    pending_order.pos = new_order.pos;
 
-    order_database->InsertEntry(StringAny<24, int>(user_name, order_ID),
+    order_database->InsertEntry(StringAny<24, int>(user_name, new_order.pos),
                                 new_order);
     pending_order_database->InsertEntry(
         StringIntInt<24>(train_ID, start_day.get_value(), order_ID),
@@ -854,84 +848,64 @@ string TrainManagement::buy_ticket(Command &line, AccountManagement &accounts) {
 
 string TrainManagement::query_order(Command &line,
                                     AccountManagement &accounts) {
-  line.next_token();
-  string user_name = line.next_token();
+  line.parse_args();
+  string user_name(line.get('u'));
   if (!accounts.login_pool.count(user_name))
     return "-1"; //未登录
-  int cnt = 0;
 
-  // todo : 修改为区间查找，查找所有关键字包含 user_name 的 order
-  vector<Order> orders;
-  StringAnyComparator<24, int> tp_cmp(1);
-  // todo: 分析真正的含义，只考虑user_name
-  order_database->ScanKey(StringAny<24, int>(user_name, 0), &orders, tp_cmp);
-  if (orders.empty())
+  //该用户的订单是关键字 (user_name, pos) 的一段区间，从 pos 大的一端
+  //倒着扫描，就是从新到旧，边扫边输出
+  string output;
+  int cnt = order_database->ReverseScan(
+      StringAny<24, int>(user_name, 0), StringAny<24, int>(user_name, MAX_INT),
+      [&](const StringAny<24, int> &, const Order &order) {
+        if (order.status == success)
+          output += "\n[success] ";
+        else if (order.status == pending)
+          output += "\n[pending] ";
+        else
+          output += "\n[refunded] ";
+
+        output += string(order.train_ID) + " " + string(order.from_station) +
+                  " " + (order.leaving_time + order.start_day).transfer() +
+                  " -> " + string(order.to_station) + " " +
+                  (order.arriving_time + order.start_day).transfer() + " " +
+                  to_string(order.price) + " " + to_string(order.num);
+        return true;
+      });
+  if (!cnt)
     return "0"; //没有订单
-
-  cnt = orders.size();
-  //从新到旧排序（大到小） , 可能不需要？
-  // todo: 修改为 bpt 后，按照关键字 Order_ID 读取，就不用排序
-  // 事实上，目前的bpt做不到，所以还是要 sort
-  Sort(orders, 0, cnt - 1, order_cmp);
-
-  string output = to_string(cnt);
-  for (int i = 0; i <= cnt - 1; ++i) {
-    if (orders[i].status == success)
-      output += "\n[success] ";
-    else if (orders[i].status == pending)
-      output += "\n[pending] ";
-    else
-      output += "\n[refunded] ";
-
-    output += string(orders[i].train_ID) + " " +
-              string(orders[i].from_station) + " " +
-              (orders[i].leaving_time + orders[i].start_day).transfer() +
-              " -> " + string(orders[i].to_station) + " " +
-              (orders[i].arriving_time + orders[i].start_day).transfer() + " " +
-              to_string(orders[i].price) + " " + to_string(orders[i].num);
-  }
-  return output;
+  return to_string(cnt) + output;
 }
 
 string TrainManagement::refund_ticket(Command &line,
                                       AccountManagement &accounts) {
-  string opt = line.next_token(), user_name;
-  int x = 1;
-  while (!opt.empty()) {
-    if (opt == "-u")
-      user_name = line.next_token();
-    else if (opt == "-n")
-      x = string_to_int(line.next_token());
-
-    opt = line.next_token();
-  }
+  line.parse_args();
+  string user_name(line.get('u'));
+  int x = line.get('n').empty() ? 1 : string_to_int(line.get('n'));
 
   if (!accounts.login_pool.count(user_name))
     return "-1"; //未登录
 
-  // todo: 区间查询
-  int cnt = 0;
-  vector<Order> orders;
-  StringAnyComparator<24, int> tp_cmp(1);
-  // todo: 分析真正的含义，只考虑user_name
-  order_database->ScanKey(StringAny<24, int>(user_name, 0), &orders, tp_cmp);
-  if (orders.empty())
+  //第 x 新的订单就是该用户的第 cnt - x + 1 个订单，按位置直接查找
+  int cnt = count_orders(user_name);
+  if (!cnt)
     return "0"; //没有订单
-  cnt = orders.size();
-  //从新到旧排序（大到小） , 可能不需要？
-  // todo: 修改为 bpt 后，按照关键字 Order_ID 读取，就不用排序
-  // 事实上，目前的bpt做不到，所以还是要 sort
-  Sort(orders, 0, cnt - 1, order_cmp);
   if (x > cnt)
     return "-1"; //显然超出订单总数
-  x--;           // 1-base--->0-base
-  if (orders[x].status == refunded)
+  StringAny<24, int> order_key(user_name, cnt - x + 1);
+  vector<Order> orders;
+  order_database->SearchKey(order_key, &orders);
+  if (orders.empty())
+    return "-1"; //位置索引与订单数不一致
+  if (orders[0].status == refunded)
     return "-1"; //重复退款
 
-  Order refund_order = orders[x]; //临时存储
-  orders[x].status = refunded;
-  order_database->InsertEntry(StringAny<24, int>(user_name, orders[x].order_ID),
-                              orders[x]);
+  Order refund_order = orders[0]; //临时存储
+  push_record(REFUND_TICKET, line.timestamp, user_name, order_key.GetAny(),
+              refund_order.status);
+  orders[0].status = refunded;
+  order_database->InsertEntry(order_key, orders[0]);
 
   if (refund_order.status == pending) { //候补的票要修改 pending_database
     //            string key = string(refund_order.train_ID) +
@@ -959,50 +933,47 @@ string TrainManagement::refund_ticket(Command &line,
                           refund_order.num);
 
   //退票后有空缺，判断候补的订单现在是否能买
-  int CNT = 0;
-  // todo: 同样是区间查找
-  vector<PendingOrder> pending_orders;
-  StringIntIntComparator<24> tp_cmp2(1);
-  pending_order_database->ScanKey(
+  //候补订单的关键字是 (train_ID, 日期, order_ID)，区间扫描已按 order_ID
+  //从小到大，早买票就早补票。在叶子中原地判断区间和座位，只记下补上的订单，
+  //扫描结束后再修改索引
+  vector<StringIntInt<24>> filled_keys;
+  vector<StringAny<24, int>> filled_orders;
+  pending_order_database->Scan(
       StringIntInt<24>(refund_order.train_ID,
                        refund_order.start_day.get_value(),
                        refund_order.order_ID),
-      &pending_orders, tp_cmp2);
-  CNT = pending_orders.size();
-
-  // todo: 同理的排序修改，但是是从小到大，因为早买票就早补票
-  Sort(pending_orders, 0, CNT - 1, pending_order_cmp);
-
-  for (int i = 0; i <= CNT - 1; ++i) {
-    //之前写错了，只要候补订单的区间和退掉的票有交集，就可以买
-    if (pending_orders[i].from > refund_order.to ||
-        pending_orders[i].to < refund_order.from)
-      continue;
-    if (tp_daytrain.query_seat(pending_orders[i].from,
-                               pending_orders[i].to - 1) >=
-        pending_orders[i].num) {
-      //座位足够，而且只能全买
-      tp_daytrain.modify_seat(pending_orders[i].from, pending_orders[i].to - 1,
-                              -pending_orders[i].num);
-      //相应地删除pending_database
-      pending_order_database->DeleteEntry(StringIntInt<24>(
-          pending_orders[i].train_ID, pending_orders[i].start_day.get_value(),
-          pending_orders[i].order_ID));
-
-      //修改 order 中的状态
-      //                key = string(pending_orders[i].user_name) +
-      //                to_string(pending_orders[i].order_ID);
-      vector<Order> tmp;
-      order_database->SearchKey(StringAny<24, int>(pending_orders[i].user_name,
-                                                   pending_orders[i].order_ID),
-                                &tmp);
-      Order success_order = tmp[0];
-      success_order.status = success;
-      order_database->InsertEntry(
-          StringAny<24, int>(pending_orders[i].user_name,
-                             pending_orders[i].order_ID),
-          success_order);
-    }
+      StringIntInt<24>(refund_order.train_ID,
+                       refund_order.start_day.get_value(), MAX_INT),
+      [&](const StringIntInt<24> &key, const PendingOrder &pending_order) {
+        //之前写错了，只要候补订单的区间和退掉的票有交集，就可以买
+        if (pending_order.from > refund_order.to ||
+            pending_order.to < refund_order.from)
+          return true;
+        if (tp_daytrain.query_seat(pending_order.from, pending_order.to - 1) >=
+            pending_order.num) {
+          //座位足够，而且只能全买
+          tp_daytrain.modify_seat(pending_order.from, pending_order.to - 1,
+                                  -pending_order.num);
+          filled_keys.push_back(key);
+          filled_orders.push_back(
+              StringAny<24, int>(pending_order.user_name, pending_order.pos));
+          push_record(FILL_ORDER, line.timestamp, pending_order.user_name,
+                      pending_order.pos);
+        }
+        return true;
+      });
+
+  //相应地删除pending_database
+  for (size_t i = 0; i < filled_keys.size(); ++i)
+    pending_order_database->DeleteEntry(filled_keys[i]);
+  //修改 order 中的状态，关键字排好序后一起修改，相邻的订单共用一次查找
+  if (!filled_orders.empty()) {
+    Sort(filled_orders, 0, filled_orders.size() - 1, order_key_cmp);
+    order_database->ModifyEntries(
+        filled_orders,
+        [](const StringAny<24, int> &, Order *order) {
+          order->status = success;
+        });
   }
   //把新补票后减少的座位，写入文件中
   daytrain_database->InsertEntry(
@@ -1015,27 +986,159 @@ string TrainManagement::refund_ticket(Command &line,
   return "0";
 }
 
-//-------------------todo: special command
+//-------------------special command
 
 string TrainManagement::rollback(Command &line, AccountManagement &accounts) {
+  line.parse_args();
+  int timestamp = string_to_int(line.get('t'));
+  if (timestamp > line.timestamp)
+    return "-1"; //不能回滚到之后的时刻
+  accounts.rollback(timestamp);
+
+  //座位、订单、候补订单的修改先记在内存中，同一个关键字只写回一次，
+  //回滚几千条购票的开销取决于撤销记录的数量，而不是逐条重放命令
+  WriteBatch<BPlusTreeIndexNTS<StringAny<24, int>, DayTrain,
+                               StringAnyComparator<24, int>>,
+             StringAny<24, int>, DayTrain,
+             KeyLess<StringAny<24, int>, StringAnyComparator<24, int>, 3>>
+      daytrains(daytrain_database);
+  WriteBatch<BPlusTreeHeapIndexNTS<StringAny<24, int>, Order,
+                                   StringAnyComparator<24, int>>,
+             StringAny<24, int>, Order,
+             KeyLess<StringAny<24, int>, StringAnyComparator<24, int>, 3>>
+      orders(order_database);
+  WriteBatch<BPlusTreeIndexNTS<StringIntInt<24>, PendingOrder,
+                               StringIntIntComparator<24>>,
+             StringIntInt<24>, PendingOrder,
+             KeyLess<StringIntInt<24>, StringIntIntComparator<24>, 2>>
+      pending_orders(pending_order_database);
+
+  //订单的座位加回 val 张，val 为负则重新占座
+  auto modify_seat = [&](const Order &order, int val) {
+    StringAny<24, int> key(order.train_ID, order.start_day.get_value());
+    DayTrain day_train;
+    if (!daytrains.get(key, day_train))
+      return; //座位记录不应缺失，缺失时跳过，不写回未初始化的值
+    day_train.modify_seat(order.from, order.to - 1, val);
+    daytrains.put(key, day_train);
+  };
+  auto pending_key = [](const Order &order) {
+    return StringIntInt<24>(order.train_ID, order.start_day.get_value(),
+                            order.order_ID);
+  };
+  auto put_pending = [&](const Order &order) {
+    PendingOrder pending_order(order.train_ID, order.user_name,
+                               order.start_day, order.num, order.from,
+                               order.to, order.order_ID);
+    pending_order.pos = order.pos;
+    pending_orders.put(pending_key(order), pending_order);
+  };
+
+  TrainRecord record;
+  while (!undo_stack->IsEmpty()) {
+    undo_stack->Top(record);
+    if (record.timestamp <= timestamp)
+      break;
+    undo_stack->Pop(record);
+
+    if (record.type == ADD_TRAIN)
+      train_database->DeleteEntry(String<24>(record.id));
+    else if (record.type == DELETE_TRAIN) {
+      Train train;
+      deleted_trains->Pop(train);
+      train_database->InsertEntry(String<24>(record.id), train);
+    } else if (record.type == RELEASE_TRAIN) {
+      //之后的购票已经撤销，删去发布时建立的座位、车站和路线
+      vector<Train> ans;
+      train_database->SearchKey(String<24>(record.id), &ans);
+      Train train = ans[0];
+      train.is_released = false;
+      train_database->InsertEntry(String<24>(record.id), train);
+      for (auto i = train.start_sale_date; i <= train.end_sale_date; i += 1440)
+        daytrains.erase(StringAny<24, int>(record.id, i.get_value()));
+      for (int i = 1; i <= train.station_num; ++i) {
+        station_database->DeleteEntry(
+            DualString<32, 24>(train.stations[i], record.id));
+        vector<int> ids;
+        station_id_database->SearchKey(String<32>(train.stations[i]), &ids);
+        if (!ids.empty() && ids[0] >= record.pos) //这次发布时分配的编号
+          station_id_database->DeleteEntry(String<32>(train.stations[i]));
+      }
+      route_database->DeleteEntry(String<24>(record.id));
+      station_id_num = record.pos;
+    } else {
+      StringAny<24, int> key(record.id, record.pos);
+      Order order;
+      if (!orders.get(key, order))
+        continue; //订单不应缺失，缺失时跳过这条记录
+      if (record.type == BUY_TICKET) {
+        if (order.status == success)
+          modify_seat(order, order.num);
+        else
+          pending_orders.erase(pending_key(order));
+        orders.erase(key);
+        order_num = order.order_ID - 1;
+      } else if (record.type == REFUND_TICKET) {
+        if (record.status == success)
+          modify_seat(order, -order.num);
+        else
+          put_pending(order);
+        order.status = record.status;
+        orders.put(key, order);
+      } else { // FILL_ORDER，补上的订单回到候补
+        modify_seat(order, order.num);
+        put_pending(order);
+        order.status = pending;
+        orders.put(key, order);
+      }
+    }
+  }
+
+  daytrains.flush();
+  orders.flush();
+  pending_orders.flush();
+  station_cache.clear(); //发布被撤销的车次可能还在缓存中
   return "0";
 }
 
 string TrainManagement::clean(AccountManagement &accounts) {
   //        accounts.user_data.clear();
   //        accounts.username_to_pos.clear();
+  //先清空撤销记录，崩溃在中途时不会留下对应不上的记录
+  accounts.user_stack->Clear();
+  undo_stack->Clear();
+  deleted_trains->Clear();
+
   accounts.user_database->Clear();
   accounts.login_pool.clear();
 
   train_database->Clear();
   daytrain_database->Clear();
   station_database->Clear();
+  station_cache.clear();
+  station_id_database->Clear();
+  route_database->Clear();
+  station_id_num = 0;
   order_database->Clear();
   pending_order_database->Clear();
 
   return "0";
 }
 
+string TrainManagement::compact(AccountManagement &accounts) {
+  accounts.user_database->Compact();
+
+  train_database->Compact();
+  daytrain_database->Compact();
+  station_database->Compact();
+  station_id_database->Compact();
+  route_database->Compact();
+  order_database->Compact();
+  pending_order_database->Compact();
+
+  return "0";
+}
+
 string TrainManagement::exit(AccountManagement &accounts) {
   accounts.login_pool.clear(); //用户下线
   //其实可以省略，因为在内存中的变量会自动清除？
@@ -7,11 +7,100 @@
 
 #include "Account.h"
 #include "TrainSystem.h"
+#include "recovery/log_manager.h"
+#include "stack/stack_manager.hpp"
+#include "storage/index/b_plus_tree_heap_index_nts.h"
 #include "storage/index/b_plus_tree_index_nts.h"
 #include "type/string_any.h"
 #include "type/string_int_int.h"
 
 namespace thomas {
+//各个数据库缓冲池的替换策略。LRU-K 让 query_ticket 等扫描只读一次的叶子页先被换出，
+//B+ 树的内部节点留在 96 页的缓冲池中
+const REPLACER_TYPE DATABASE_REPLACER = REPLACER_TYPE::LRU_K;
+
+//回滚用的撤销记录，修改数据库的命令成功后按时间戳压栈，回滚时倒着弹出
+enum UndoType {
+  ADD_USER,
+  MODIFY_PROFILE,
+  ADD_TRAIN,
+  DELETE_TRAIN,
+  RELEASE_TRAIN,
+  BUY_TICKET,
+  REFUND_TICKET,
+  FILL_ORDER // 退票后补上的候补订单，和退票的时间戳相同
+};
+
+class UserRecord { //用户数据库的撤销记录
+public:
+  int type, timestamp;
+  User user; // ADD_USER 只用到用户名，MODIFY_PROFILE 是修改前的用户
+};
+
+class TrainRecord { //其余数据库的撤销记录，只存关键字，撤销时再读出数据
+public:
+  int type, timestamp;
+  char id[22];   //车次记录是 train_ID，订单记录是 user_name
+  int pos;       //订单的位置；RELEASE_TRAIN 是发布前已分配的车站编号数
+  Status status; // REFUND_TICKET 退票前订单的状态
+};
+
+template <typename Key, typename Comparator, int... Category>
+class KeyLess { //把数据库的比较器换成 map 需要的小于号，Category 是比较器的参数
+public:
+  bool operator()(const Key &lhs, const Key &rhs) const {
+    return Comparator(Category...)(lhs, rhs) < 0;
+  }
+};
+
+//回滚时对一个数据库的修改先记在内存中，同一个关键字只保留最后的值，
+//最后按关键字的顺序一起写回，相邻的关键字共用叶子
+template <typename Index, typename Key, typename Value, typename Less>
+class WriteBatch {
+private:
+  class Write {
+  public:
+    bool exists; //写回后是否存在
+    Value value;
+  };
+
+  Index *index;
+  sjtu::map<Key, Write, Less> writes;
+
+public:
+  explicit WriteBatch(Index *_index) : index(_index) {}
+
+  bool get(const Key &key, Value &value) { //先读内存中的修改，没有再查数据库
+    auto iter = writes.find(key);
+    if (iter != writes.end()) {
+      value = iter->second.value;
+      return iter->second.exists;
+    }
+    vector<Value> ans;
+    index->SearchKey(key, &ans);
+    if (ans.empty())
+      return false;
+    value = ans[0];
+    return true;
+  }
+
+  void put(const Key &key, const Value &value) {
+    writes[key] = Write{true, value};
+  }
+
+  void erase(const Key &key) { writes[key].exists = false; }
+
+  void flush() {
+    for (auto iter = writes.begin(); iter != writes.end(); ++iter) {
+      if (iter->second.exists)
+        index->InsertEntry(iter->first, iter->second.value);
+      else
+        index->DeleteEntry(iter->first);
+    }
+    writes.clear();
+  }
+};
+
 class AccountManagement {
   friend class TrainManagement;
 
@@ -27,8 +116,12 @@ private:
   BPlusTreeIndexNTS<String<24>, User, StringComparator<24>> *user_database;
   StringComparator<24> cmp1;
 
+  StackManager<UserRecord> *user_stack; //用于 rollback
+
+  void rollback(int timestamp); //撤销时间戳之后的修改，由 TrainManagement 调用
+
 public:
-  AccountManagement();
+  explicit AccountManagement(LogManager *log_manager = nullptr); //数据库的修改写入预写日志
   AccountManagement(const string &file_name);
   ~AccountManagement();
 
@@ -56,24 +149,45 @@ private:
   StringAnyComparator<24, int> cmp3;
   StringAnyComparator<24, int> cmp4;
   StringIntIntComparator<24> cmp5; //
+  StringComparator<32> cmp6;
 
-  BPlusTreeIndexNTS<String<24>, Train, StringComparator<24>> *train_database;
+  //Train 和 Order 很大，放在表堆里，叶子只存 RID
+  BPlusTreeHeapIndexNTS<String<24>, Train, StringComparator<24>>
+      *train_database;
   BPlusTreeIndexNTS<DualString<32, 24>, Station, DualStringComparator<32, 24>>
       *station_database;
   BPlusTreeIndexNTS<StringAny<24, int>, DayTrain, StringAnyComparator<24, int>>
       *daytrain_database;
-  BPlusTreeIndexNTS<StringAny<24, int>, Order, StringAnyComparator<24, int>>
-      *order_database;
+  BPlusTreeHeapIndexNTS<StringAny<24, int>, Order,
+                        StringAnyComparator<24, int>> *order_database;
   BPlusTreeIndexNTS<StringIntInt<24>, PendingOrder, StringIntIntComparator<24>>
       *pending_order_database;
+  BPlusTreeIndexNTS<String<32>, int, StringComparator<32>>
+      *station_id_database; //车站名 -> 车站编号
+  BPlusTreeIndexNTS<String<24>, TrainRoute, StringComparator<24>>
+      *route_database; //已发布车次的紧凑路线
 
   //临时数组的大小不是110
   int order_num; //临时存储 order 总数
 
+  StationCache station_cache; // station_database 在内存中的缓存
+  int station_id_num;          //已分配的车站编号数
+  vector<int> transfer_head; // query_transfer 哈希连接的桶，按车站编号下标
+
+  StackManager<TrainRecord> *undo_stack; //用于 rollback
+  StackManager<Train> *deleted_trains;   //被删除的车次，撤销删除时放回
+
+  void push_record(int type, int timestamp, const string &id, int pos = 0,
+                   Status status = success);
+
+  vector<Station> *get_stations(const string &station_name); //途经该站的车次
+  int get_station_id(const string &station_name); //没有编号时分配一个新编号
+  int count_orders(const string &user_name); //该用户的订单数
+
 public:
   friend void OUTPUT(TrainManagement &all, const string &train_ID);
 
-  TrainManagement();
+  explicit TrainManagement(LogManager *log_manager = nullptr);
   //    TrainManagement(const string &file_name);
   ~TrainManagement();
 
@@ -89,6 +203,7 @@ public:
   string refund_ticket(Command &line, AccountManagement &accounts);
   string rollback(Command &line, AccountManagement &accounts);
   string clean(AccountManagement &accounts);
+  string compact(AccountManagement &accounts); //离线整理数据库文件，去掉空闲页
   string exit(AccountManagement &accounts); //退出系统，所有用户下线
 };
 
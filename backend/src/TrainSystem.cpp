@@ -3,49 +3,55 @@
 namespace thomas {
 //-------------------------------------------------class Train
 
-Train::Train(const string &_train_ID, const int &_station_num,
-             const int &_total_seat_num, const string &_stations,
-             const string &_prices, const string &_start_time,
-             const string &_travel_time, const string &_stop_over_times,
-             const string &_sale_date, const string &_type) {
-  strcpy(train_ID, _train_ID.c_str());
+Train::Train(string_view _train_ID, const int &_station_num,
+             const int &_total_seat_num, string_view _stations,
+             string_view _prices, string_view _start_time,
+             string_view _travel_time, string_view _stop_over_times,
+             string_view _sale_date, string_view _type) {
+  memcpy(train_ID, _train_ID.data(), _train_ID.length());
+  train_ID[_train_ID.length()] = '\0';
   station_num = _station_num;
   total_seat_num = _total_seat_num;
   type = _type[0];
 
-  Command c1(_prices, '|');
-  string tp = c1.next_token();
+  string_view tp;
+  Splitter c1(_prices);
   int k = 1;
   price_sum[0] = price_sum[1] = 0; //到第一站不用钱
-  while (!tp.empty()) {
+  while (c1.next(tp)) {
     k++;
     price_sum[k] = price_sum[k - 1] + string_to_int(tp);
-    tp = c1.next_token();
   }
 
-  Command c2(_stations, '|');
-  tp = c2.next_token();
+  Splitter c2(_stations);
   k = 0;
-  while (!tp.empty()) {
-    strcpy(stations[++k], tp.c_str());
-    tp = c2.next_token();
+  while (c2.next(tp)) {
+    ++k;
+    memcpy(stations[k], tp.data(), tp.length());
+    stations[k][tp.length()] = '\0';
   }
 
-  start_time = TimeType("06-01 " + _start_time);
-  Command c3(_sale_date, '|');
-  start_sale_date = TimeType(c3.next_token() + " 00:00");
-  end_sale_date = TimeType(c3.next_token() + " 00:00");
+  //时刻 hh:mm 是 06-01 当天的分钟数
+  start_time = TimeType(string_to_int(_start_time.substr(0, 2)) * 60 +
+                        string_to_int(_start_time.substr(3, 2)));
+  Splitter c3(_sale_date);
+  c3.next(tp);
+  start_sale_date = TimeType(tp);
+  c3.next(tp);
+  end_sale_date = TimeType(tp);
 
-  Command c4(_travel_time, '|'), c5(_stop_over_times, '|');
+  Splitter c4(_travel_time), c5(_stop_over_times);
   arriving_times[1] = TimeType(0);
   leaving_times[1] = start_time;
   for (int i = 1; i <= station_num - 2; ++i) { //可以自动判断 只有2站 的情况
-    arriving_times[i + 1] = leaving_times[i] + string_to_int(c4.next_token());
-    leaving_times[i + 1] =
-        arriving_times[i + 1] + string_to_int(c5.next_token());
+    c4.next(tp);
+    arriving_times[i + 1] = leaving_times[i] + string_to_int(tp);
+    c5.next(tp);
+    leaving_times[i + 1] = arriving_times[i + 1] + string_to_int(tp);
   }
+  c4.next(tp);
   arriving_times[station_num] =
-      leaving_times[station_num - 1] + string_to_int(c4.next_token());
+      leaving_times[station_num - 1] + string_to_int(tp);
   leaving_times[station_num] = MAX_INT;
 
   is_released = false;
@@ -57,29 +63,98 @@ bool Train::operator<(const Train &rhs) const {
 
 //--------------------------------------------------class DayTrain
 
-void DayTrain::modify_seat(int l, int r, int val) {
+//区间 [l, r] 的最小值和区间加，车站数不超过 maxn，直接扫描连续的数组
+//（分块最小值在 100 站时反而更慢，见 backend/benchmark.cpp），循环交给编译器向量化
+static int range_min(const int *a, int l, int r) {
+  int ans = MAX_INT;
   for (int i = l; i <= r; ++i)
-    seat_num[i] += val;
+    ans = std::min(ans, a[i]);
+  return ans;
 }
 
-int DayTrain::query_seat(int l, int r) {
-  int ans = MAX_INT;
+static void range_add(int *a, int l, int r, int val) {
   for (int i = l; i <= r; ++i)
-    ans = std::min(ans, seat_num[i]);
-  return ans;
+    a[i] += val;
+}
+
+DayTrain::DayTrain(int station_num, int seat) {
+  for (int i = 0; i < maxn; ++i)
+    seat_num[i] = (1 <= i && i <= station_num) ? seat : 0;
+}
+
+int DayTrain::get_seat(int i) const { return seat_num[i]; }
+
+void DayTrain::modify_seat(int l, int r, int val) {
+  range_add(seat_num, l, r, val);
+}
+
+int DayTrain::query_seat(int l, int r) const {
+  return range_min(seat_num, l, r);
 }
 
 //--------------------------------------------------class Station
 
-Station::Station(const string &_train_ID, const string &_station_name,
-                 const int &_price_sum, const TimeType &_start_sale_time,
+Station::Station(const string &_train_ID, const int &_price_sum,
+                 const TimeType &_start_sale_time,
                  const TimeType &_end_sale_time, const TimeType &_arriving_time,
                  const TimeType &_leaving_time, const int &_index)
-    : price_sum(_price_sum), start_sale_time(_start_sale_time),
+    : price_sum(_price_sum), index(_index), start_sale_time(_start_sale_time),
       end_sale_time(_end_sale_time), arriving_time(_arriving_time),
-      leaving_time(_leaving_time), index(_index) {
+      leaving_time(_leaving_time) {
   strcpy(train_ID, _train_ID.c_str());
-  strcpy(station_name, _station_name.c_str());
+}
+
+//--------------------------------------------------class TrainRoute
+
+TrainRoute::TrainRoute(const Train &train, const int *ids)
+    : station_num(train.station_num) {
+  for (int i = 1; i <= station_num; ++i) {
+    station_ids[i] = ids[i];
+    price_sum[i] = train.price_sum[i];
+    arriving_times[i] = train.arriving_times[i];
+    leaving_times[i] = train.leaving_times[i];
+  }
+}
+
+//--------------------------------------------------class StationCache
+
+vector<Station> *StationCache::find(const string &station_name) {
+  auto it = lists.find(station_name);
+  if (it == lists.end())
+    return nullptr;
+  return &it->second;
+}
+
+vector<Station> *StationCache::insert(const string &station_name,
+                                      const vector<Station> &list) {
+  entry_num += list.size();
+  vector<Station> &target = lists[station_name];
+  target = list;
+  return &target;
+}
+
+void StationCache::add(const string &station_name, const Station &station) {
+  vector<Station> *list = find(station_name);
+  if (list == nullptr)
+    return; //没有缓存的车站，查询时会从 B+ 树读到最新的数据
+
+  //保持按 train_ID 有序：从末尾插入，再向前交换到正确的位置
+  list->push_back(station);
+  for (int i = list->size() - 1;
+       i > 0 && strcmp((*list)[i - 1].train_ID, (*list)[i].train_ID) > 0; --i)
+    std::swap((*list)[i - 1], (*list)[i]);
+  entry_num++;
+}
+
+void StationCache::trim() {
+  //超出容量就整体清空，下次查询时再从 B+ 树读入
+  if (entry_num > STATION_CACHE_CAPACITY)
+    clear();
+}
+
+void StationCache::clear() {
+  lists.clear();
+  entry_num = 0;
 }
 
 //---------------------------------------------------class Ticket
@@ -3,6 +3,7 @@
 
 #include "Account.h"
 #include "FileStorage.h"
+#include "container/vector.hpp"
 
 //#include "Library.h"
 
@@ -11,6 +12,7 @@
 
 const int maxn = 101;           //最大车站数，不是1e6...
 const int MAX_INT = 0x7fffffff; //最大座位数/日期
+const int STATION_CACHE_CAPACITY = 1 << 18; // StationCache 中最多缓存的 Station 数
 
 // class TrainID{
 //     friend class Train;
@@ -26,6 +28,8 @@ class TrainManagement;
 class Train { //一列火车
   friend class TrainManagement;
 
+  friend class TrainRoute;
+
 private:
   char train_ID[22], stations[maxn][32]; //途径车站
   int station_num, total_seat_num;       //途径的车站数、座位数
@@ -41,11 +45,12 @@ private:
 public:
   Train() = default;
 
-  Train(const string &_train_ID, const int &_station_num,
-        const int &_total_seat_num, const string &_stations,
-        const string &_prices, const string &_start_time,
-        const string &_travel_time, const string &_stop_over_times,
-        const string &_sale_date, const string &_type);
+  //各个 '|' 列表直接按视图切分，不分配内存
+  Train(string_view _train_ID, const int &_station_num,
+        const int &_total_seat_num, string_view _stations,
+        string_view _prices, string_view _start_time, string_view _travel_time,
+        string_view _stop_over_times, string_view _sale_date,
+        string_view _type);
 
   bool operator<(const Train &rhs) const; //不需要？
   friend void OUTPUT(TrainManagement &all, const string &train_ID);
@@ -59,33 +64,73 @@ class Station { //属于某个车次的车站，额外存储一次信息;
 
   friend class Ticket;
 
+  friend class StationCache;
+
 private:
-  char train_ID[22], station_name[32];
-  TimeType start_sale_time, end_sale_time, arriving_time,
-      leaving_time;     //该车次中，到站与出站时间
+  char train_ID[22];
+  //车站名只存在 station_database 的关键字 (station_name, train_ID) 里，
+  //这里只留查询需要的字段，一条记录 48 字节
   int price_sum, index; //继承自Train，index表示是该车次的第几站
-  // todo : 同理把 train_id 和 station_name 复合起来,
-  //  排序时，只需要考虑station_name
+  TimeType start_sale_time, end_sale_time, arriving_time,
+      leaving_time; //该车次中，到站与出站时间
 
 public:
   Station() = default;
 
-  Station(const string &_train_ID, const string &_station_name,
-          const int &_price_sum, const TimeType &_start_sale_time,
-          const TimeType &_end_sale_time, const TimeType &_arriving_time,
-          const TimeType &_leaving_time, const int &_index);
+  Station(const string &_train_ID, const int &_price_sum,
+          const TimeType &_start_sale_time, const TimeType &_end_sale_time,
+          const TimeType &_arriving_time, const TimeType &_leaving_time,
+          const int &_index);
 
   friend bool time_cmp(const Ticket &a, const Ticket &b);
 
   friend bool cost_cmp(const Ticket &a, const Ticket &b);
 };
 
+class TrainRoute { //已发布车次的紧凑路线，站名换成整数编号
+  // release_train 时建立，query_transfer 用它按中转站编号做哈希连接，
+  //不再需要读出整个 Train 并比较字符串
+  friend class TrainManagement;
+
+private:
+  int station_num;
+  int station_ids[maxn]; //每一站的编号，下标从1开始，和 Train 一致
+  int price_sum[maxn];
+  TimeType arriving_times[maxn], leaving_times[maxn];
+
+public:
+  TrainRoute() = default;
+
+  TrainRoute(const Train &train, const int *ids); // ids[i] 为第 i 站的编号
+};
+
+class StationCache { //常驻内存的 车站 -> 途经车次 索引
+  //每个车站对应一个按 train_ID 排好序的 Station 列表（和 B+ 树中的顺序一致），
+  // query_ticket 直接对两个列表做归并，不用每次都扫描 station_database
+private:
+  sjtu::map<string, vector<Station>> lists;
+  int entry_num = 0; //缓存中 Station 的总数
+
+public:
+  StationCache() = default;
+
+  vector<Station> *find(const string &station_name); //未缓存时返回 nullptr
+  vector<Station> *insert(const string &station_name,
+                          const vector<Station> &list); //缓存从B+树读出的列表
+  void add(const string &station_name,
+           const Station &station); // release_train 时维护已缓存的列表
+  void trim(); //查询开始前调用，保证查询过程中拿到的列表不会被释放
+  void clear();
+};
+
 class Ticket { //一张车票
   friend class TrainManagement;
 
 private:
   Station s, t; //起始站和终点站
   //因为 Station 是某一车次下的 车站，所以不用存储额外信息
+  TimeType start_day; //该车次从始发站出发的日期
+  int seat = 0;       //余票，在排序前按 B+ 树的顺序批量查出
 public:
   Ticket() = default;
 
@@ -110,7 +155,10 @@ private:
 public:
   DayTrain() = default;
 
-  int query_seat(int l, int r); //查询第l站到第r站,最多能坐的人数
+  DayTrain(int station_num, int seat); //第1站到第station_num站都有seat个座位
+
+  int get_seat(int i) const;          //第i站的座位数
+  int query_seat(int l, int r) const; //查询第l站到第r站,最多能坐的人数
   void modify_seat(int l, int r, int val); //区间修改
 
   friend void OUTPUT(TrainManagement &all, const string &train_ID);
@@ -125,10 +173,7 @@ private:
   char user_name[22], train_ID[22]; //用户名，车次
   int num, price, order_ID; //订单编号,从1开始(充当下单时间，用来排序)
   // num是票数, price 是单价
-  // todo: 实际上，ull中的关键字是 user_name + order_ID，应该修改为pair类型
-  //  排序时，以 order_id 为关键字，
-  //  但是存储时是以user_name为第一关键字
-  int pos; // refund_ticket 时临时用来存储位置
+  int pos; //该用户的第几个订单，从1开始，order_database 的关键字是 (user_name, pos)
 
   TimeType start_day, leaving_time, arriving_time;
   Status status;                         //订单当前状态
@@ -143,8 +188,6 @@ public:
         const TimeType &_leaving_time, const TimeType &_arriving_time,
         const Status &_status, const int &_from, const int &_to,
         const string &_from_station, const string &_to_station);
-
-  friend bool order_cmp(const Order &a, const Order &b);
 };
 
 class PendingOrder { //候补的订单
@@ -158,7 +201,7 @@ private:
   //  把 start_sale_date 和 order_ID 合成为一个 pair,然后与 train_ID 复合
   //  排序时，以 order_id 为关键字
   //  同理，但是存储时是以train_ID为第一关键字
-  int pos; // refund_ticket 时临时用来存储位置
+  int pos; //对应订单在该用户订单中的位置，补票时用来找到订单
 
 public:
   PendingOrder() = default;
@@ -166,8 +209,6 @@ public:
   PendingOrder(const string &_train_ID, const string &_user_name,
                const TimeType &_start_day, const int &_num, const int &_from,
                const int &_to, const int &_order_ID);
-
-  friend bool pending_order_cmp(const PendingOrder &a, const PendingOrder &b);
 };
 
 } // namespace thomas
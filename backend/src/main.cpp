@@ -1,3 +1,4 @@
+#include <chrono>
 #include <cmath>
 #include <cstdio>
 #include <cstring>
@@ -12,78 +13,113 @@ using namespace std;
 using namespace thomas;
 
 // vector<Command> commands; //用来回滚
-AccountManagement accounts; //声明在外部，防止数组太大，爆栈空间
-TrainManagement trains;
+LogManager log_manager("wal.log"); //预写日志，先于各数据库构造，打开前完成崩溃恢复
+AccountManagement accounts(&log_manager); //声明在外部，防止数组太大，爆栈空间
+TrainManagement trains(&log_manager);
+
+//命令按批执行：读满 COMMIT_BATCH_SIZE 条、超过 COMMIT_WINDOW 毫秒或输入暂时读完时，
+//整批提交并同步一次日志，再输出这一批的结果，输出的命令都已经持久化
+const int COMMIT_BATCH_SIZE = 256;
+const int COMMIT_WINDOW = 20;
+
+string output; //本批命令的输出
+int batch_num = 0;
+auto batch_start = chrono::steady_clock::now();
+
+void commit_batch() {
+    log_manager.Commit(true); //索引和撤销记录在同一次提交中持久化
+    fputs(output.c_str(), stdout);
+    fflush(stdout);
+    output.clear();
+    batch_num = 0;
+    log_manager.CheckpointIfLong(); //检查点要写回所有页，放在输出之后，提交了的批次先输出
+}
 
 int main() {
     string input;
+    ios::sync_with_stdio(false); //输入有缓冲，才能知道是否还有读好的命令；输出仍用 stdio
 
 //    freopen("test_data/normal/pressure_1_easy/2.in", "r", stdin);
 //    freopen("output.txt", "w", stdout);
 
     while (getline(cin, input)) {
         Command cmd(input);
-        string time = cmd.next_token();
+        string_view time = cmd.next_view();
         int l = time.length();
         cmd.timestamp = string_to_int(time.substr(1, l - 2));
         //        commands.push_back(cmd);
 
-        printf("[%d] ", cmd.timestamp);
+        if (!batch_num)
+            batch_start = chrono::steady_clock::now();
+        ++batch_num;
+        output += "[" + to_string(cmd.timestamp) + "] ";
 //    cout << "[" << cmd.timestamp << "] "; //输出时间戳，方便调试
-        string s = cmd.next_token();
+        string_view s = cmd.next_view();
         if (s == "add_user")
-            printf("%s\n", accounts.add_user(cmd).c_str());
+            output += accounts.add_user(cmd) + "\n";
 //      cout << accounts.add_user(cmd) << endl;
         else if (s == "login")
-            printf("%s\n", accounts.login(cmd).c_str());
+            output += accounts.login(cmd) + "\n";
 //      cout << accounts.login(cmd) << endl;
         else if (s == "logout")
-            printf("%s\n", accounts.logout(cmd).c_str());
+            output += accounts.logout(cmd) + "\n";
 //      cout << accounts.logout(cmd) << endl;
         else if (s == "query_profile")
-            printf("%s\n", accounts.query_profile(cmd).c_str());
+            output += accounts.query_profile(cmd) + "\n";
 //      cout << accounts.query_profile(cmd) << endl;
         else if (s == "modify_profile")
-            printf("%s\n", accounts.modify_profile(cmd).c_str());
+            output += accounts.modify_profile(cmd) + "\n";
 //      cout << accounts.modify_profile(cmd) << endl;
 
         else if (s == "add_train")
-            printf("%s\n", trains.add_train(cmd).c_str());
+            output += trains.add_train(cmd) + "\n";
 //      cout << trains.add_train(cmd) << endl;
         else if (s == "release_train")
-            printf("%s\n", trains.release_train(cmd).c_str());
+            output += trains.release_train(cmd) + "\n";
 //      cout << trains.release_train(cmd) << endl;
         else if (s == "query_train")
-            printf("%s\n", trains.query_train(cmd).c_str());
+            output += trains.query_train(cmd) + "\n";
 //      cout << trains.query_train(cmd) << endl;
         else if (s == "delete_train")
-            printf("%s\n", trains.delete_train(cmd).c_str());
+            output += trains.delete_train(cmd) + "\n";
 //      cout << trains.delete_train(cmd) << endl;
         else if (s == "query_ticket")
-            printf("%s\n", trains.query_ticket(cmd).c_str());
+            output += trains.query_ticket(cmd) + "\n";
 //      cout << trains.query_ticket(cmd) << endl;
         else if (s == "query_transfer")
-            printf("%s\n", trains.query_transfer(cmd).c_str());
+            output += trains.query_transfer(cmd) + "\n";
 //    cout << trains.query_transfer(cmd) << endl; // trains.query_transfer(cmd)
 
         else if (s == "buy_ticket")
-            printf("%s\n", trains.buy_ticket(cmd, accounts).c_str());
+            output += trains.buy_ticket(cmd, accounts) + "\n";
 //      cout << trains.buy_ticket(cmd, accounts) << endl;
         else if (s == "query_order")
-            printf("%s\n", trains.query_order(cmd, accounts).c_str());
+            output += trains.query_order(cmd, accounts) + "\n";
 //    cout << trains.query_order(cmd, accounts) << endl;
         else if (s == "refund_ticket")
-            printf("%s\n", trains.refund_ticket(cmd, accounts).c_str());
+            output += trains.refund_ticket(cmd, accounts) + "\n";
 //    cout << trains.refund_ticket(cmd, accounts) << endl;
         else if (s == "rollback")
-            printf("%s\n", trains.rollback(cmd, accounts).c_str());
+            output += trains.rollback(cmd, accounts) + "\n";
 //      cout << trains.rollback(cmd, accounts) << endl;
         else if (s == "clean")
-            printf("%s\n", trains.clean(accounts).c_str());
+            output += trains.clean(accounts) + "\n";
 //      cout << trains.clean(accounts) << endl;
-        else if (s == "exit")
+        else if (s == "compact")
+            output += trains.compact(accounts) + "\n";
+        else if (s == "exit") {
+            commit_batch();
             trains.exit(accounts);
+        }
+
+        //回滚弹出的撤销记录先提交，之后的命令才能覆盖它们在磁盘上的位置
+        if (s == "rollback" || batch_num >= COMMIT_BATCH_SIZE ||
+            cin.rdbuf()->in_avail() <= 0 ||
+            chrono::steady_clock::now() - batch_start >=
+                chrono::milliseconds(COMMIT_WINDOW))
+            commit_batch();
     }
+    commit_batch();
 
     return 0;
 }
\ No newline at end of file
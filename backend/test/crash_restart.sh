@@ -0,0 +1,84 @@
+#!/bin/bash
+# Kill the system with SIGKILL while it runs a batch, restart it on the commands not committed, and compare with a run
+# stopped cleanly after the last committed command. A batch is printed only after its commit, but it can be killed
+# between the two, so the batch in flight is either committed or not, and the restart has to match one of the two
+# runs, on a rollback to a command before the crash too.
+# usage: crash_restart.sh <code> <input>
+set -e
+code=$(realpath "$1")
+input=$(realpath "$2")
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+mkdir "$work/crash"
+
+timestamp() { sed -n "$1p" "$input" | cut -d']' -f1 | tr -d '['; }
+total=$(wc -l < "$input")
+# the batch in flight starts with an add_train after the half, which needs no login, so it changes the state after
+# a restart, and it's small enough to be read at once, so that it's a batch of its own
+half=$(awk -v half=$((total / 2)) 'NR > half && $2 == "add_train" { print NR - 1; exit }' "$input")
+half=${half:-$((total / 2))}
+chunk=8
+half_ts=$(timestamp $half)
+chunk_ts=$(timestamp $((half + chunk)))
+rollback_ts=$(timestamp $((total / 4)))
+end_ts=$(timestamp "$total")
+
+# feed the first half, then the chunk in one write, and kill the process while it runs the chunk
+mkfifo "$work/in"
+(cd "$work/crash" && exec "$code" < "$work/in" > out) &
+pid=$!
+exec 3> "$work/in"
+head -n $half "$input" >&3
+for i in $(seq 600); do
+  grep -q "^\[$half_ts\] " "$work/crash/out" && break
+  sleep 0.1
+done
+sed -n "$((half + 1)),$((half + chunk))p" "$input" > "$work/chunk.in"
+dd if="$work/chunk.in" bs=65536 status=none >&3
+sleep 0.00$((RANDOM % 4))
+{
+  kill -9 $pid
+  wait $pid
+} 2> /dev/null || true
+exec 3>&-
+
+last=$(grep -o '^\[[0-9]*\]' "$work/crash/out" | tail -n 1 | tr -d '[]')
+if [ -z "$last" ] || [ "$last" -lt "$half_ts" ]; then
+  echo "the first half wasn't printed"
+  exit 1
+fi
+echo "killed after [$last]"
+
+# restart a copy of the crashed files on the commands after the committed one, then a rollback and the queries of
+# the whole input to compare the states, and run the same from a clean stop after the committed one
+check() {
+  local committed=$1 dir="$work/run_$1"
+  mkdir "$dir" "$dir/ref"
+  cp -r "$work/crash" "$dir/crash"
+  {
+    awk -v last="$committed" '{ ts = substr($1, 2, length($1) - 2) + 0; if (ts > last) print }' "$input"
+    echo "[$((end_ts + 1))] rollback -t $rollback_ts"
+    grep -E '^\[[0-9]+\] (login|query_)' "$input" | awk -v base=$((end_ts + 1)) '{ $1 = "[" (base + NR) "]"; print }'
+    echo "[$((end_ts + 1000000))] exit"
+  } > "$dir/rest.in"
+  awk -v last="$committed" '{ ts = substr($1, 2, length($1) - 2) + 0; if (ts <= last) print }
+    END { print "[" last + 1 "] exit" }' "$input" > "$dir/ref/prefix.in"
+  (cd "$dir/ref" && "$code" < prefix.in > /dev/null)
+
+  (cd "$dir/crash" && "$code" < ../rest.in > out2)
+  (cd "$dir/ref" && "$code" < ../rest.in > out2)
+  cmp -s "$dir/crash/out2" "$dir/ref/out2"
+}
+
+if check "$last"; then
+  exit 0
+fi
+# the batch after the last printed one committed without being printed, it ends at a rollback or the chunk
+next=$(awk -v last="$last" '{ ts = substr($1, 2, length($1) - 2) + 0
+  if (ts > last && ($2 == "rollback" || ts == end)) { print ts; exit } }' end="$chunk_ts" "$work/chunk.in")
+if [ -n "$next" ] && check "$next"; then
+  echo "the batch up to [$next] was committed but not printed"
+  exit 0
+fi
+diff "$work/run_$last/crash/out2" "$work/run_$last/ref/out2" | head -n 20
+exit 1
@@ -0,0 +1,15 @@
+#!/bin/bash
+# Run the system on an input in an empty directory and compare its output with the expected one.
+# usage: run_case.sh <code> <input> <output>
+set -e
+code=$(realpath "$1")
+input=$(realpath "$2")
+output=$(realpath "$3")
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+cd "$work"
+"$code" < "$input" > out
+if ! cmp out "$output"; then
+  diff out "$output" | head -n 20
+  exit 1
+fi
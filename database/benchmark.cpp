@@ -13,23 +13,44 @@
 #include <chrono>
 #include <cstddef>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <fstream>
 #include <future>
 #include <map>
 #include <random>
 #include <thread>
 #include <vector>
 
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/page_table.h"
 #include "common/config.h"
+#include "container/linked_hashmap.hpp"
 #include "container/vector.hpp"
+#include "storage/index/b_plus_tree_heap_index_nts.h"
+#include "storage/index/b_plus_tree_index_nts.h"
 #include "storage/index/b_plus_tree_index_ts.h"
+#include "storage/page/b_plus_tree_leaf_page.h"
 #include "thread/thread_pool.h"
+#include "type/dual_string.h"
 #include "type/string.h"
 
+/* threads and buffer pool instances can be overrided too, e.g. -DTHREAD_NUMBER=4 -DBENCHMARK_INSTANCES=4 */
+#ifndef THREAD_NUMBER
 #define THREAD_NUMBER 1
-/* the buffer pool size if pre-defined, but can be overrided */
-#define BUFFER_POOL_SIZE 10000
+#endif
+#ifndef BENCHMARK_INSTANCES
+#define BENCHMARK_INSTANCES 1
+#endif
+/* the buffer pool size if pre-defined, but can be overrided, e.g. -DBENCHMARK_POOL_SIZE=96 to force evictions */
+#ifndef BENCHMARK_POOL_SIZE
+#define BENCHMARK_POOL_SIZE 10000
+#endif
+#define BUFFER_POOL_SIZE BENCHMARK_POOL_SIZE
+#ifndef NUMBER
 #define NUMBER 1000000
+#endif
 
 using namespace thomas;  // NOLINT
 
@@ -39,7 +60,8 @@ void Test4() {  // NOLINT
   BPlusTreeIndexTS<String<48>, size_t, StringComparator<48>> *index_tree;
   StringComparator<48> comparator;
   index_tree =
-      new BPlusTreeIndexTS<String<48>, size_t, StringComparator<48>>("index", comparator, pool, BUFFER_POOL_SIZE);
+      new BPlusTreeIndexTS<String<48>, size_t, StringComparator<48>>("index", comparator, pool, BUFFER_POOL_SIZE,
+                                                                     false, BENCHMARK_INSTANCES);
   std::vector<std::future<size_t>> results;
 
   auto one = std::chrono::system_clock::now();
@@ -191,7 +213,8 @@ void Test4() {  // NOLINT
   delete pool;
   delete index_tree;
   auto eight = std::chrono::system_clock::now();
-  std::cout << NUMBER << " " << PAGE_SIZE << " " << BUFFER_POOL_SIZE << " " << THREAD_NUMBER << std::endl;
+  std::cout << NUMBER << " " << PAGE_SIZE << " " << BUFFER_POOL_SIZE << " " << THREAD_NUMBER << " "
+            << BENCHMARK_INSTANCES << std::endl;
   std::cout << "insert cost: sec_cost: " << 1.0 * (two - one).count() / 1e9  // NOLINT
             << std::endl;
   std::cout << "find cost: sec_cost: " << 1.0 * (three - one).count() / 1e9  // NOLINT
@@ -214,7 +237,8 @@ void Test5() {
   BPlusTreeIndexTS<String<48>, size_t, StringComparator<48>> *index_tree;
   StringComparator<48> comparator;
   index_tree =
-      new BPlusTreeIndexTS<String<48>, size_t, StringComparator<48>>("index", comparator, pool, BUFFER_POOL_SIZE);
+      new BPlusTreeIndexTS<String<48>, size_t, StringComparator<48>>("index", comparator, pool, BUFFER_POOL_SIZE,
+                                                                     false, BENCHMARK_INSTANCES);
   std::vector<std::future<size_t>> results;
   auto begin = std::chrono::system_clock::now();
   for (int i = 0; i < NUMBER; ++i) {
@@ -259,7 +283,8 @@ void Test5() {
   delete pool;
   delete index_tree;
   auto end = std::chrono::system_clock::now();
-  std::cout << NUMBER << " " << PAGE_SIZE << " " << BUFFER_POOL_SIZE << " " << THREAD_NUMBER << std::endl;
+  std::cout << NUMBER << " " << PAGE_SIZE << " " << BUFFER_POOL_SIZE << " " << THREAD_NUMBER << " "
+            << BENCHMARK_INSTANCES << std::endl;
   std::cout << "final cost:" << 1.0 * (end - begin).count() / 1e9  // NOLINT
             << std::endl;
 }
@@ -270,7 +295,8 @@ void Test6() {
   BPlusTreeIndexTS<String<48>, size_t, StringComparator<48>> *index_tree;
   StringComparator<48> comparator;
   index_tree =
-      new BPlusTreeIndexTS<String<48>, size_t, StringComparator<48>>("index", comparator, pool, BUFFER_POOL_SIZE);
+      new BPlusTreeIndexTS<String<48>, size_t, StringComparator<48>>("index", comparator, pool, BUFFER_POOL_SIZE,
+                                                                     false, BENCHMARK_INSTANCES);
   std::vector<std::future<size_t>> results;
   auto begin = std::chrono::system_clock::now();
   for (int i = 0; i < NUMBER; ++i) {
@@ -332,11 +358,533 @@ void Test6() {
   delete pool;
   delete index_tree;
   auto end = std::chrono::system_clock::now();
-  std::cout << NUMBER << " " << PAGE_SIZE << " " << BUFFER_POOL_SIZE << " " << THREAD_NUMBER << std::endl;
+  std::cout << NUMBER << " " << PAGE_SIZE << " " << BUFFER_POOL_SIZE << " " << THREAD_NUMBER << " "
+            << BENCHMARK_INSTANCES << std::endl;
   std::cout << "first cost:" << 1.0 * (middle - begin).count() / 1e9  // NOLINT
             << std::endl;
   std::cout << "second cost:" << 1.0 * (end - middle).count() / 1e9  // NOLINT
             << std::endl;
 }
 
-int main() { Test6(); }
\ No newline at end of file
+/* the latency of a buffer pool hit: the page table alone, then FetchPage with UnpinPage */
+void Test7() {
+  std::mt19937 gen(2022);
+  std::vector<page_id_t> ids(NUMBER);
+  for (int i = 0; i < NUMBER; ++i) {
+    ids[i] = static_cast<page_id_t>(gen() % BUFFER_POOL_SIZE);
+  }
+
+  linked_hashmap<page_id_t, frame_id_t> hashmap;
+  PageTable page_table(BUFFER_POOL_SIZE);
+  for (int i = 0; i < BUFFER_POOL_SIZE; ++i) {
+    hashmap[i] = i;
+    page_table.Insert(i, i);
+  }
+  long long check = 0;  // NOLINT
+  auto begin = std::chrono::system_clock::now();
+  for (int i = 0; i < NUMBER; ++i) {
+    check += hashmap.find(ids[i])->second;
+  }
+  auto middle = std::chrono::system_clock::now();
+  for (int i = 0; i < NUMBER; ++i) {
+    check -= page_table.Find(ids[i]);
+  }
+  auto end = std::chrono::system_clock::now();
+  std::cout << NUMBER << " " << BUFFER_POOL_SIZE << " " << check << std::endl;
+  std::cout << "linked_hashmap find ns: " << 1.0 * (middle - begin).count() / NUMBER  // NOLINT
+            << std::endl;
+  std::cout << "page table find ns: " << 1.0 * (end - middle).count() / NUMBER  // NOLINT
+            << std::endl;
+
+  auto *disk_manager = new DiskManager("index.db");
+  auto *bpm = new BufferPoolManagerInstance(BUFFER_POOL_SIZE, disk_manager);
+  for (int i = 0; i < BUFFER_POOL_SIZE; ++i) {
+    page_id_t page_id;
+    bpm->NewPage(&page_id);
+    bpm->UnpinPage(page_id, false);
+  }
+  begin = std::chrono::system_clock::now();
+  for (int i = 0; i < NUMBER; ++i) {
+    check += bpm->FetchPage(ids[i])->GetPinCount();
+    bpm->UnpinPage(ids[i], false);
+  }
+  end = std::chrono::system_clock::now();
+  std::cout << "fetch hit ns: " << 1.0 * (end - begin).count() / NUMBER << " " << check  // NOLINT
+            << std::endl;
+  delete bpm;
+  delete disk_manager;
+}
+
+/* point lookups on a non-thread-safe tree, through the buffer pool and through the swizzled inner pages */
+void Test8() {
+  std::mt19937 gen(2022);
+  std::vector<String<48>> keys(NUMBER);
+  for (int i = 0; i < NUMBER; ++i) {
+    std::string key_string;
+    for (int j = 0; j < 15; ++j) {
+      key_string += static_cast<char>(gen() % 26 + 'a');
+    }
+    keys[i].SetValue(key_string);
+  }
+
+  for (int swizzling = 0; swizzling < 2; ++swizzling) {
+    StringComparator<48> comparator;
+    auto *index_tree = new BPlusTreeIndexNTS<String<48>, size_t, StringComparator<48>>(
+        "index", comparator, BUFFER_POOL_SIZE, false, REPLACER_TYPE::LRU, swizzling == 1);
+    index_tree->Clear();
+    for (int i = 0; i < NUMBER; ++i) {
+      index_tree->InsertEntry(keys[i], i);
+    }
+
+    size_t check = 0;
+    auto begin = std::chrono::system_clock::now();
+    for (int round = 0; round < 10; ++round) {
+      for (int i = 0; i < NUMBER; ++i) {
+        vector<size_t> res;
+        index_tree->SearchKey(keys[(i * 7919LL + round) % NUMBER], &res);
+        check += res[0];
+      }
+    }
+    auto end = std::chrono::system_clock::now();
+    std::cout << NUMBER << " " << BUFFER_POOL_SIZE << " swizzling " << swizzling << " check " << check << std::endl;
+    std::cout << "search ns: " << 1.0 * (end - begin).count() / NUMBER / 10  // NOLINT
+              << std::endl;
+    delete index_tree;
+  }
+}
+
+/* trains inline in the leaves against trains in a table heap */
+template <typename IndexType>
+void Test9Run(const char *name, const std::vector<String<24>> &keys, size_t fan_out) {
+  StringComparator<24> comparator;
+  auto *index_tree = new IndexType("index", comparator, BUFFER_POOL_SIZE);
+  index_tree->Clear();
+  Train train;
+  for (int i = 0; i < NUMBER; ++i) {
+    index_tree->InsertEntry(keys[i], train);
+  }
+
+  size_t check = 0;
+  auto begin = std::chrono::system_clock::now();
+  for (int round = 0; round < 10; ++round) {
+    for (int i = 0; i < NUMBER; ++i) {
+      vector<Train> res;
+      index_tree->SearchKey(keys[(i * 7919LL + round) % NUMBER], &res);
+      check += res.size();
+    }
+  }
+  auto end = std::chrono::system_clock::now();
+  std::cout << NUMBER << " " << BUFFER_POOL_SIZE << " " << name << " leaf fan-out " << fan_out << " check " << check
+            << std::endl;
+  std::cout << "search ns: " << 1.0 * (end - begin).count() / NUMBER / 10  // NOLINT
+            << std::endl;
+  delete index_tree;
+}
+
+void Test9() {
+  std::mt19937 gen(2022);
+  std::vector<String<24>> keys(NUMBER);
+  for (int i = 0; i < NUMBER; ++i) {
+    std::string key_string;
+    for (int j = 0; j < 15; ++j) {
+      key_string += static_cast<char>(gen() % 26 + 'a');
+    }
+    keys[i].SetValue(key_string);
+  }
+
+  Test9Run<BPlusTreeIndexNTS<String<24>, Train, StringComparator<24>>>(
+      "inline", keys, (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE - 16) / (sizeof(String<24>) + sizeof(Train)));
+  Test9Run<BPlusTreeHeapIndexNTS<String<24>, Train, StringComparator<24>>>(
+      "heap", keys, (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE - 16) / (sizeof(String<24>) + sizeof(RID)));
+}
+
+/* the file size under churn, with the freed pages reused, and after the compaction */
+void Test10() {
+  std::mt19937 gen(2022);
+  std::vector<String<48>> keys(NUMBER);
+  for (int i = 0; i < NUMBER; ++i) {
+    std::string key_string;
+    for (int j = 0; j < 15; ++j) {
+      key_string += static_cast<char>(gen() % 26 + 'a');
+    }
+    keys[i].SetValue(key_string);
+  }
+  auto file_size = []() {
+    std::ifstream file("index.db", std::ios::binary | std::ios::ate);
+    return static_cast<size_t>(file.tellg());
+  };
+
+  StringComparator<48> comparator;
+  auto *index_tree =
+      new BPlusTreeIndexNTS<String<48>, size_t, StringComparator<48>>("index", comparator, BUFFER_POOL_SIZE);
+  index_tree->Clear();
+  for (int round = 0; round < 5; ++round) {
+    /* insert all, then delete all but every tenth */
+    for (int i = 0; i < NUMBER; ++i) {
+      index_tree->InsertEntry(keys[i], i);
+    }
+    for (int i = 0; i < NUMBER; ++i) {
+      if (i % 10 != 0) {
+        index_tree->DeleteEntry(keys[i]);
+      }
+    }
+    index_tree->Flush();
+    std::cout << "round " << round << " file size " << file_size() << std::endl;
+  }
+
+  auto begin = std::chrono::system_clock::now();
+  index_tree->Compact();
+  auto end = std::chrono::system_clock::now();
+  size_t check = 0;
+  for (int i = 0; i < NUMBER; i += 10) {
+    vector<size_t> res;
+    index_tree->SearchKey(keys[i], &res);
+    check += res.size() == 1 && res[0] == static_cast<size_t>(i);
+  }
+  std::cout << "compacted file size " << file_size() << " check " << check << " of " << (NUMBER + 9) / 10
+            << " compact ms: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count()
+            << std::endl;
+  delete index_tree;
+}
+
+/* station-like keys, long shared prefixes in the first string */
+void Test11() {
+  std::mt19937 gen(2022);
+  std::vector<DualString<32, 24>> keys(NUMBER);
+  for (int i = 0; i < NUMBER; ++i) {
+    std::string station = "station_of_the_line_" + std::to_string(gen() % 1000);
+    std::string train;
+    for (int j = 0; j < 15; ++j) {
+      train += static_cast<char>(gen() % 26 + 'a');
+    }
+    keys[i].SetValue(station, train);
+  }
+
+  DualStringComparator<32, 24> comparator(2);
+  auto *index_tree = new BPlusTreeIndexNTS<DualString<32, 24>, Station, DualStringComparator<32, 24>>(
+      "index", comparator, BUFFER_POOL_SIZE);
+  index_tree->Clear();
+  Station station;
+  auto begin = std::chrono::system_clock::now();
+  for (int i = 0; i < NUMBER; ++i) {
+    index_tree->InsertEntry(keys[i], station);
+  }
+  auto middle = std::chrono::system_clock::now();
+  size_t check = 0;
+  for (int round = 0; round < 10; ++round) {
+    for (int i = 0; i < NUMBER; ++i) {
+      vector<Station> res;
+      index_tree->SearchKey(keys[(i * 7919LL + round) % NUMBER], &res);
+      check += res.size();
+    }
+  }
+  auto end = std::chrono::system_clock::now();
+  std::cout << NUMBER << " " << BUFFER_POOL_SIZE << " check " << check << std::endl;
+  std::cout << "insert ns: " << 1.0 * (middle - begin).count() / NUMBER  // NOLINT
+            << " search ns: " << 1.0 * (end - middle).count() / NUMBER / 10 << std::endl;
+  delete index_tree;
+}
+
+/* the search inside full leaf pages, which is what remains of a point lookup once the pages are in the buffer pool */
+void Test12() {
+  using LeafPage = BPlusTreeLeafPage<String<48>, size_t, StringComparator<48>>;
+  std::mt19937 gen(2022);
+  StringComparator<48> comparator;
+  auto *data = new char[PAGE_SIZE];
+  auto *leaf_page = reinterpret_cast<LeafPage *>(data);
+  leaf_page->Init(1, INVALID_PAGE_ID, (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE - 16) / (48 + sizeof(size_t)) - 1);
+  std::vector<String<48>> keys;
+  while (leaf_page->GetSize() < leaf_page->GetMaxSize() - 1) {
+    std::string key_string;
+    for (int j = 0; j < 15; ++j) {
+      key_string += static_cast<char>(gen() % 26 + 'a');
+    }
+    String<48> key;
+    key.SetValue(key_string);
+    if (leaf_page->Insert(key, keys.size(), comparator) != -1) {
+      keys.push_back(key);
+    }
+  }
+
+  /* one page stays in the cache, while a lookup on one of a thousand pages mostly misses */
+  for (int page_num : {1, 1024}) {
+    auto *pages = new char[static_cast<size_t>(PAGE_SIZE) * page_num];
+    for (int i = 0; i < page_num; ++i) {
+      memcpy(pages + static_cast<size_t>(PAGE_SIZE) * i, data, PAGE_SIZE);
+    }
+    size_t check = 0;
+    auto begin = std::chrono::system_clock::now();
+    for (int i = 0; i < NUMBER; ++i) {
+      auto *page = reinterpret_cast<LeafPage *>(pages + static_cast<size_t>(PAGE_SIZE) * (i * 7919LL % page_num));
+      size_t value;
+      page->Lookup(keys[(i * 104729LL) % keys.size()], &value, comparator);
+      check += value;
+    }
+    auto end = std::chrono::system_clock::now();
+    std::cout << NUMBER << " lookups on " << page_num << " leaves of " << leaf_page->GetSize() << " check " << check
+              << std::endl;
+    std::cout << "search ns: " << 1.0 * (end - begin).count() / NUMBER << std::endl;  // NOLINT
+    delete[] pages;
+  }
+  delete[] data;
+}
+
+/* sorted loads, one by one against bulk loading, into an empty tree and in batches of 90 into a filled one */
+void Test13() {
+  std::vector<std::pair<String<48>, size_t>> pairs(NUMBER);
+  for (int i = 0; i < NUMBER; ++i) {
+    char key_string[16];
+    snprintf(key_string, sizeof(key_string), "%09d", i);
+    pairs[i].first.SetValue(key_string);
+    pairs[i].second = i;
+  }
+
+  StringComparator<48> comparator;
+  auto check_all = [&](BPlusTreeIndexNTS<String<48>, size_t, StringComparator<48>> *index_tree, int step) {
+    size_t check = 0;
+    for (int i = 0; i < NUMBER; i += step) {
+      vector<size_t> res;
+      index_tree->SearchKey(pairs[i].first, &res);
+      check += res.size() == 1 && res[0] == pairs[i].second;
+    }
+    return check;
+  };
+
+  for (int bulk = 0; bulk < 2; ++bulk) {
+    auto *index_tree = new BPlusTreeIndexNTS<String<48>, size_t, StringComparator<48>>("index", comparator,
+                                                                                      BUFFER_POOL_SIZE);
+    index_tree->Clear();
+    auto begin = std::chrono::system_clock::now();
+    if (bulk == 1) {
+      index_tree->BulkLoad(pairs.data(), pairs.data() + NUMBER);
+    } else {
+      for (int i = 0; i < NUMBER; ++i) {
+        index_tree->InsertEntry(pairs[i].first, pairs[i].second);
+      }
+    }
+    auto end = std::chrono::system_clock::now();
+    std::cout << "empty tree, bulk " << bulk << " size " << index_tree->Size() << " found " << check_all(index_tree, 1)
+              << " insert ns: " << 1.0 * (end - begin).count() / NUMBER << std::endl;  // NOLINT
+    delete index_tree;
+  }
+
+  /* the even thousands are there first, then each odd thousand comes in batches */
+  std::vector<std::pair<String<48>, size_t>> base;
+  for (int i = 0; i < NUMBER; ++i) {
+    if (i / 1000 % 2 == 0) {
+      base.push_back(pairs[i]);
+    }
+  }
+  for (int bulk = 0; bulk < 2; ++bulk) {
+    auto *index_tree = new BPlusTreeIndexNTS<String<48>, size_t, StringComparator<48>>("index", comparator,
+                                                                                      BUFFER_POOL_SIZE);
+    index_tree->Clear();
+    index_tree->BulkLoad(base.data(), base.data() + base.size(), 0.7);
+    auto begin = std::chrono::system_clock::now();
+    for (int i = 1000; i < NUMBER; i += 2000) {
+      for (int j = i; j < std::min(i + 1000, NUMBER); j += 90) {
+        int batch_end = std::min(std::min(j + 90, i + 1000), NUMBER);
+        if (bulk == 1) {
+          index_tree->BulkLoad(pairs.data() + j, pairs.data() + batch_end);
+        } else {
+          for (int k = j; k < batch_end; ++k) {
+            index_tree->InsertEntry(pairs[k].first, pairs[k].second);
+          }
+        }
+      }
+    }
+    auto end = std::chrono::system_clock::now();
+    std::cout << "batches, bulk " << bulk << " size " << index_tree->Size() << " found " << check_all(index_tree, 1)
+              << " insert ns: " << 1.0 * (end - begin).count() / (NUMBER - base.size()) << std::endl;  // NOLINT
+
+    /* the tree stays sound under removal */
+    for (int i = 0; i < NUMBER; i += 2) {
+      index_tree->DeleteEntry(pairs[i].first);
+    }
+    std::cout << "after removal size " << index_tree->Size() << " found " << check_all(index_tree, 1) << std::endl;
+    delete index_tree;
+  }
+}
+
+/* sorted batches of nearby keys, one search per key against one multi-get per batch */
+void Test14() {
+  std::vector<String<48>> keys(NUMBER);
+  for (int i = 0; i < NUMBER; ++i) {
+    char key_string[16];
+    snprintf(key_string, sizeof(key_string), "%09d", i);
+    keys[i].SetValue(key_string);
+  }
+  StringComparator<48> comparator;
+  auto *index_tree =
+      new BPlusTreeIndexNTS<String<48>, size_t, StringComparator<48>>("index", comparator, BUFFER_POOL_SIZE);
+  index_tree->Clear();
+  for (int i = 0; i < NUMBER; ++i) {
+    index_tree->InsertEntry(keys[i], i);
+  }
+
+  /* a batch takes every third key from a random window, like the trains through a station */
+  const int batch_size = 64;
+  std::mt19937 gen(2022);
+  std::vector<vector<String<48>>> batches(NUMBER / batch_size);
+  for (auto &batch : batches) {
+    int first = gen() % (NUMBER - batch_size * 3);
+    for (int i = 0; i < batch_size; ++i) {
+      batch.push_back(keys[first + i * 3]);
+    }
+  }
+
+  for (int multi = 0; multi < 2; ++multi) {
+    size_t check = 0;
+    auto begin = std::chrono::system_clock::now();
+    for (auto &batch : batches) {
+      if (multi == 1) {
+        vector<size_t> res;
+        index_tree->MultiGet(batch, &res);
+        for (size_t i = 0; i < res.size(); ++i) {
+          check += res[i];
+        }
+      } else {
+        for (size_t i = 0; i < batch.size(); ++i) {
+          vector<size_t> res;
+          index_tree->SearchKey(batch[i], &res);
+          check += res[0];
+        }
+      }
+    }
+    auto end = std::chrono::system_clock::now();
+    std::cout << NUMBER << " " << BUFFER_POOL_SIZE << " multi " << multi << " check " << check << std::endl;
+    std::cout << "search ns: " << 1.0 * (end - begin).count() / (batches.size() * batch_size)  // NOLINT
+              << std::endl;
+  }
+  delete index_tree;
+}
+
+/* the n-th newest order of a user, from all the orders read out against from the keys counted in place */
+void Test15() {
+  const int user_num = NUMBER / 100;
+  StringAnyComparator<24, int> comparator(3);
+  auto *index_tree = new BPlusTreeHeapIndexNTS<StringAny<24, int>, Order, StringAnyComparator<24, int>>(
+      "index", comparator, BUFFER_POOL_SIZE);
+  index_tree->Clear();
+  Order order;
+  for (int i = 0; i < NUMBER; ++i) {
+    index_tree->InsertEntry(StringAny<24, int>("user_" + std::to_string(i % user_num), i), order);
+  }
+
+  std::mt19937 gen(2022);
+  for (int scan = 0; scan < 2; ++scan) {
+    size_t check = 0;
+    auto begin = std::chrono::system_clock::now();
+    for (int i = 0; i < user_num; ++i) {
+      std::string user_name = "user_" + std::to_string(gen() % user_num);
+      if (scan == 1) {
+        StringAny<24, int> lower(user_name, 0);
+        StringAny<24, int> upper(user_name, 0x7fffffff);
+        int cnt = index_tree->ScanKeys(lower, upper, [](const StringAny<24, int> &key) { return true; });
+        int rank = cnt - 1;
+        StringAny<24, int> order_key;
+        index_tree->ScanKeys(lower, upper, [&](const StringAny<24, int> &key) {
+          if (rank--) {
+            return true;
+          }
+          order_key = key;
+          return false;
+        });
+        vector<Order> res;
+        index_tree->SearchKey(order_key, &res);
+        check += cnt + res.size();
+      } else {
+        vector<Order> res;
+        StringAnyComparator<24, int> standby_comparator(1);
+        index_tree->ScanKey(StringAny<24, int>(user_name, 0), &res, standby_comparator);
+        check += res.size() + 1;
+      }
+    }
+    auto end = std::chrono::system_clock::now();
+    std::cout << NUMBER << " " << BUFFER_POOL_SIZE << " scan " << scan << " check " << check << std::endl;
+    std::cout << "query ns: " << 1.0 * (end - begin).count() / user_num << std::endl;  // NOLINT
+  }
+  delete index_tree;
+}
+
+/* the newest order of a user, by counting and scanning forward, or by a backward walk after deletions */
+void Test16() {
+  const int user_num = NUMBER / 100;
+  StringAnyComparator<24, int> comparator(3);
+  auto *index_tree = new BPlusTreeHeapIndexNTS<StringAny<24, int>, Order, StringAnyComparator<24, int>>(
+      "index", comparator, BUFFER_POOL_SIZE);
+  index_tree->Clear();
+  Order order;
+  for (int i = 0; i < NUMBER; ++i) {
+    index_tree->InsertEntry(StringAny<24, int>("user_" + std::to_string(i % user_num), i), order);
+  }
+  /* the leaves are merged and redistributed, so that the prev links are changed too */
+  std::mt19937 gen(2022);
+  for (int i = 0; i < NUMBER; ++i) {
+    if (gen() % 3 != 0) {
+      index_tree->DeleteEntry(StringAny<24, int>("user_" + std::to_string(i % user_num), i));
+    }
+  }
+
+  for (int scan = 0; scan < 2; ++scan) {
+    size_t check = 0;
+    auto begin = std::chrono::system_clock::now();
+    for (int i = 0; i < user_num; ++i) {
+      std::string user_name = "user_" + std::to_string(gen() % user_num);
+      StringAny<24, int> lower(user_name, 0);
+      StringAny<24, int> upper(user_name, 0x7fffffff);
+      StringAny<24, int> order_key;
+      if (scan == 0) {
+        int rank = index_tree->ScanKeys(lower, upper, [](const StringAny<24, int> &key) { return true; }) - 1;
+        index_tree->ScanKeys(lower, upper, [&](const StringAny<24, int> &key) {
+          if (rank--) {
+            return true;
+          }
+          order_key = key;
+          return false;
+        });
+      } else {
+        index_tree->ReverseScanKeys(lower, upper, [&](const StringAny<24, int> &key) {
+          order_key = key;
+          return false;
+        });
+      }
+      vector<Order> res;
+      index_tree->SearchKey(order_key, &res);
+      check += res.size();
+    }
+    auto end = std::chrono::system_clock::now();
+    std::cout << NUMBER << " " << BUFFER_POOL_SIZE << " scan " << scan << " check " << check << std::endl;
+    std::cout << "query ns: " << 1.0 * (end - begin).count() / user_num << std::endl;  // NOLINT
+  }
+
+  /* the whole index backward is the same as forward */
+  vector<StringAny<24, int>> keys;
+  index_tree->ScanKeys(StringAny<24, int>("", 0), StringAny<24, int>(std::string(24, '\xff'), 0x7fffffff),
+                       [&](const StringAny<24, int> &key) {
+                         keys.push_back(key);
+                         return true;
+                       });
+  size_t matched = 0;
+  index_tree->ReverseScanKeys(StringAny<24, int>("", 0),
+                              StringAny<24, int>(std::string(24, '\xff'), 0x7fffffff),
+                              [&](const StringAny<24, int> &key) {
+                                if (comparator(key, keys[keys.size() - 1 - matched]) != 0) {
+                                  return false;
+                                }
+                                return ++matched < keys.size();
+                              });
+  std::cout << "keys " << keys.size() << " matched backward " << matched << std::endl;
+  if (matched != keys.size()) {
+    std::cerr << "the backward scan differs from the forward scan at key " << matched << std::endl;
+    std::exit(1);
+  }
+  delete index_tree;
+}
+
+/* the test to run can be overrided, e.g. -DBENCHMARK_TEST=Test7 */
+#ifndef BENCHMARK_TEST
+#define BENCHMARK_TEST Test6
+#endif
+
+int main() { BENCHMARK_TEST(); }
\ No newline at end of file
@@ -0,0 +1,666 @@
+#include "buffer/buffer_pool_manager_instance.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#include "buffer/clock_replacer.h"
+#include "buffer/innodb_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "common/exceptions.hpp"
+
+namespace thomas {
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
+                                                     THREAD_SAFE_TYPE ts_type, REPLACER_TYPE replacer_type)
+    : pool_size_(pool_size), disk_manager_(disk_manager), page_table_(pool_size), ts_type_(ts_type) {
+  // We allocate a consecutive memory space for the buffer pool.
+  pages_ = new Page[pool_size_];
+  switch (replacer_type) {
+    case REPLACER_TYPE::INNODB:
+      replacer_ = new InnodbReplacer(pool_size);
+      break;
+    case REPLACER_TYPE::CLOCK:
+      replacer_ = new ClockReplacer(pool_size);
+      break;
+    case REPLACER_TYPE::LRU_K:
+      replacer_ = new LRUKReplacer(pool_size);
+      break;
+    default:
+      replacer_ = new LRUReplacer(pool_size);
+  }
+  write_back_buffer_ = static_cast<char *>(std::aligned_alloc(DIRECT_IO_ALIGNMENT, PAGE_SIZE));
+
+  // Initially, every page is in the free list.
+  for (size_t i = 0; i < pool_size_; ++i) {
+    free_list_.push_back(static_cast<int>(i));
+  }
+}
+
+BufferPoolManagerInstance::~BufferPoolManagerInstance() {
+  StopCleaner();
+  delete[] pages_;
+  delete replacer_;
+  std::free(write_back_buffer_);
+  std::free(clean_buffer_);
+  std::free(logged_images_);
+  std::free(freed_images_);
+  std::free(deferred_pages_);
+  delete[] frame_lsns_;
+  delete[] is_changed_;
+}
+
+void BufferPoolManagerInstance::SetLogManager(LogManager *log_manager, int file_id) {
+  log_manager_ = log_manager;
+  file_id_ = file_id;
+  logged_images_ = static_cast<char *>(std::aligned_alloc(DIRECT_IO_ALIGNMENT, pool_size_ * PAGE_SIZE));
+  freed_images_ = static_cast<char *>(std::aligned_alloc(DIRECT_IO_ALIGNMENT, 2 * PAGE_SIZE));
+  deferred_pages_ = static_cast<char *>(std::aligned_alloc(DIRECT_IO_ALIGNMENT, DEFERRED_WRITE_SIZE * PAGE_SIZE));
+  frame_lsns_ = new lsn_t[pool_size_];
+  is_changed_ = new bool[pool_size_];
+  for (size_t i = 0; i < pool_size_; ++i) {
+    frame_lsns_[i] = INVALID_LSN;
+    is_changed_[i] = false;
+  }
+}
+
+void BufferPoolManagerInstance::LogFrame(frame_id_t frame_id, bool is_undoable) {
+  Page *page = &pages_[frame_id];
+  lsn_t lsn =
+      log_manager_->AppendUpdate(file_id_, page->GetPageId(), LoggedImage(frame_id), page->GetData(), is_undoable);
+  if (lsn != INVALID_LSN) {
+    frame_lsns_[frame_id] = lsn;
+  }
+  is_changed_[frame_id] = false;
+}
+
+void BufferPoolManagerInstance::DeferWrite(frame_id_t frame_id) {
+  Page *page = &pages_[frame_id];
+  LogFrame(frame_id);
+  if (log_manager_->IsDurable(frame_lsns_[frame_id])) {
+    disk_manager_->WritePage(page->GetPageId(), page->GetData());
+    return;
+  }
+  if (deferred_num_ == DEFERRED_WRITE_SIZE) {
+    WriteDeferred();
+  }
+  memcpy(deferred_pages_ + static_cast<size_t>(deferred_num_) * PAGE_SIZE, page->GetData(), PAGE_SIZE);
+  deferred_page_ids_[deferred_num_] = page->GetPageId();
+  deferred_lsns_[deferred_num_] = frame_lsns_[frame_id];
+  ++deferred_num_;
+}
+
+void BufferPoolManagerInstance::WriteDeferred() {
+  lsn_t lsn = INVALID_LSN;
+  for (int i = 0; i < deferred_num_; ++i) {
+    lsn = std::max(lsn, deferred_lsns_[i]);
+  }
+  log_manager_->Flush(lsn);
+  for (int i = 0; i < deferred_num_; ++i) {
+    disk_manager_->WritePage(deferred_page_ids_[i], deferred_pages_ + static_cast<size_t>(i) * PAGE_SIZE);
+  }
+  deferred_num_ = 0;
+}
+
+int BufferPoolManagerInstance::FindDeferred(page_id_t page_id) {
+  for (int i = 0; i < deferred_num_; ++i) {
+    if (deferred_page_ids_[i] == page_id) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void BufferPoolManagerInstance::RemoveDeferred(int index) {
+  --deferred_num_;
+  if (index != deferred_num_) {
+    memcpy(deferred_pages_ + static_cast<size_t>(index) * PAGE_SIZE,
+           deferred_pages_ + static_cast<size_t>(deferred_num_) * PAGE_SIZE, PAGE_SIZE);
+    deferred_page_ids_[index] = deferred_page_ids_[deferred_num_];
+    deferred_lsns_[index] = deferred_lsns_[deferred_num_];
+  }
+}
+
+void BufferPoolManagerInstance::DeferFreedPage(page_id_t page_id, frame_id_t frame_id) {
+  char *new_image = freed_images_ + PAGE_SIZE;
+  if (!disk_manager_->GetFreedPage(page_id, new_image)) {
+    return;
+  }
+  /* a page in the pool is never put aside at the same time */
+  int index = frame_id == -1 ? FindDeferred(page_id) : -1;
+  char *old_image = freed_images_;
+  lsn_t last_lsn = INVALID_LSN;
+  if (frame_id != -1) {
+    old_image = LoggedImage(frame_id);
+    last_lsn = frame_lsns_[frame_id];
+  } else if (index != -1) {
+    old_image = deferred_pages_ + static_cast<size_t>(index) * PAGE_SIZE;
+    last_lsn = deferred_lsns_[index];
+  } else {
+    memset(old_image, 0, PAGE_SIZE);
+    try {
+      disk_manager_->ReadPage(page_id, old_image);
+    } catch (read_less_then_a_page &error) {
+      /* the page is beyond the end of the file, which reads as zeros in the recovery */
+    }
+  }
+  lsn_t lsn = log_manager_->AppendUpdate(file_id_, page_id, old_image, new_image);
+  if (index == -1) {
+    if (deferred_num_ == DEFERRED_WRITE_SIZE) {
+      WriteDeferred();
+    }
+    index = deferred_num_++;
+    deferred_page_ids_[index] = page_id;
+  }
+  memcpy(deferred_pages_ + static_cast<size_t>(index) * PAGE_SIZE, new_image, PAGE_SIZE);
+  deferred_lsns_[index] = lsn == INVALID_LSN ? last_lsn : lsn;
+  disk_manager_->SetFreePageId(page_id);
+}
+
+page_id_t BufferPoolManagerInstance::AllocatePage() {
+  if (log_manager_ != nullptr) {
+    page_id_t page_id = disk_manager_->GetFreePageId();
+    int index = page_id == INVALID_PAGE_ID ? -1 : FindDeferred(page_id);
+    if (index != -1) {
+      /* the page stays aside, it's the logged image of the page installed on it */
+      disk_manager_->SetFreePageId(
+          *reinterpret_cast<page_id_t *>(deferred_pages_ + static_cast<size_t>(index) * PAGE_SIZE));
+      return page_id;
+    }
+  }
+  return disk_manager_->AllocatePage();
+}
+
+void BufferPoolManagerInstance::LogDirtyPages() {
+  if (log_manager_ == nullptr) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock =
+      NeedLatch() ? std::unique_lock<std::mutex>(latch_) : std::unique_lock<std::mutex>();
+  for (size_t i = 0; i < changed_frames_.size(); ++i) {
+    /* a frame evicted or logged since it's marked is no longer changed */
+    if (is_changed_[changed_frames_[i]]) {
+      LogFrame(changed_frames_[i], false);
+    }
+  }
+  changed_frames_.clear();
+}
+
+void BufferPoolManagerInstance::StartCleaner(size_t watermark) {
+  if (cleaner_running_) {
+    return;
+  }
+  cleaner_watermark_ = watermark;
+  cleaner_terminated_ = false;
+  clean_buffer_ = static_cast<char *>(std::aligned_alloc(DIRECT_IO_ALIGNMENT, PAGE_SIZE));
+  cleaner_running_ = true;
+  cleaner_ = std::thread(&BufferPoolManagerInstance::CleanerFunction, this);
+}
+
+void BufferPoolManagerInstance::StopCleaner() {
+  if (!cleaner_running_) {
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    cleaner_terminated_ = true;
+  }
+  cleaner_cv_.notify_all();
+  cleaner_.join();
+  cleaner_running_ = false;
+}
+
+void BufferPoolManagerInstance::CleanerFunction() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (!cleaner_terminated_) {
+    /* the first dirty frame among the next victims */
+    vector<frame_id_t> frames;
+    replacer_->Candidates(cleaner_watermark_, &frames);
+    frame_id_t frame_id = -1;
+    for (size_t i = 0; i < frames.size(); ++i) {
+      if (pages_[frames[i]].IsDirty()) {
+        frame_id = frames[i];
+        break;
+      }
+    }
+    if (frame_id == -1) {
+      /* woken up by evictions */
+      cleaner_cv_.wait_for(lock, std::chrono::milliseconds(CLEANER_INTERVAL));
+      continue;
+    }
+
+    /* write a copy outside the latch, the frame can't be evicted until it's done */
+    Page *page = &pages_[frame_id];
+    page_id_t page_id = page->GetPageId();
+    lsn_t lsn = INVALID_LSN;
+    if (log_manager_ != nullptr) {
+      LogFrame(frame_id);
+      lsn = frame_lsns_[frame_id];
+    }
+    memcpy(clean_buffer_, page->GetData(), PAGE_SIZE);
+    page->is_dirty_ = false;
+    cleaning_frame_id_ = frame_id;
+    lock.unlock();
+    bool is_written = true;
+    try {
+      if (log_manager_ != nullptr) {
+        log_manager_->Flush(lsn);
+      }
+      disk_manager_->WritePage(page_id, clean_buffer_);
+    } catch (std::runtime_error &error) {
+      is_written = false;
+    }
+    lock.lock();
+    if (!is_written && page->GetPageId() == page_id) {
+      page->is_dirty_ = true;
+    }
+    cleaning_frame_id_ = -1;
+    cleaned_cv_.notify_all();
+  }
+}
+
+bool BufferPoolManagerInstance::IsNextVictimCleaning() {
+  if (cleaning_frame_id_ == -1 || !free_list_.empty()) {
+    return false;
+  }
+  vector<frame_id_t> frames;
+  replacer_->Candidates(1, &frames);
+  return !frames.empty() && frames[0] == cleaning_frame_id_;
+}
+
+bool BufferPoolManagerInstance::IsPageCleaning(page_id_t page_id) {
+  if (cleaning_frame_id_ == -1) {
+    return false;
+  }
+  return page_table_.Find(page_id) == cleaning_frame_id_;
+}
+
+frame_id_t BufferPoolManagerInstance::FindFrame(DiskRequest *write_back) {
+  frame_id_t frame_id;
+
+  /* none is available */
+  if (free_list_.empty() && !replacer_->Victim(&frame_id)) {
+    return -1;
+  }
+  if (cleaner_running_) {
+    cleaner_cv_.notify_one();
+  }
+
+  if (!free_list_.empty()) {
+    /* find it from free list */
+    frame_id = free_list_.back();
+    free_list_.pop_back();
+  } else {
+    /* find it from queue */
+    Page *page = &pages_[frame_id];
+
+    /* maybe it's dirty */
+    if (page->IsDirty()) {
+      if (log_manager_ != nullptr) {
+        DeferWrite(frame_id);
+      } else if (write_back != nullptr) {
+        /* write the copy in the background, overlapping with the caller's own I/O */
+        memcpy(write_back_buffer_, page->GetData(), PAGE_SIZE);
+        write_back->is_write_ = true;
+        write_back->page_id_ = page->GetPageId();
+        write_back->data_ = write_back_buffer_;
+        disk_manager_->Submit(write_back);
+      } else {
+        disk_manager_->WritePage(page->GetPageId(), page->GetData());
+      }
+    }
+
+    /* delete the mapping */
+    page_table_.Erase(page->GetPageId());
+  }
+
+  /* initialization */
+  Page *page = &pages_[frame_id];
+  page->page_id_ = INVALID_PAGE_ID;
+  page->is_dirty_ = false;
+  page->pin_count_ = 0;
+  page->ResetMemory();
+
+  return frame_id;
+}
+
+void BufferPoolManagerInstance::WaitWriteBack(DiskRequest *write_back) {
+  if (write_back->data_ != nullptr) {
+    disk_manager_->Wait(write_back);
+  }
+}
+
+Page *BufferPoolManagerInstance::FetchPage(page_id_t page_id) {
+  std::unique_lock<std::mutex> lock =
+      NeedLatch() ? std::unique_lock<std::mutex>(latch_) : std::unique_lock<std::mutex>();
+  //  std::scoped_lock lock{latch_};
+
+  while (true) {
+    // 1.     Search the page table for the requested page (P).
+    frame_id_t frame_id = page_table_.Find(page_id);
+    if (frame_id != -1) {
+      // 1.1    If P exists, pin it and return it immediately.
+
+      /* pin it */
+      Page *page = &pages_[frame_id];
+      ++page->pin_count_;
+      replacer_->Pin(frame_id);
+
+      return page;
+    }
+    /* the victim is being written by the cleaner, and the page table might change while waiting */
+    if (!IsNextVictimCleaning()) {
+      break;
+    }
+    cleaned_cv_.wait(lock, [this] { return !IsNextVictimCleaning(); });
+  }
+  // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
+  //        Note that pages are always found from the free list first.
+  // 2.     If R is dirty, write it back to the disk.
+  // 3.     Delete R from the page table and insert P.
+  DiskRequest write_back;
+  frame_id_t frame_id = FindFrame(disk_manager_->IsAsyncPreferred() ? &write_back : nullptr);
+
+  /* none is available */
+  if (frame_id == -1) {
+    return nullptr;
+  }
+
+  /* update in page table */
+  page_table_.Insert(page_id, frame_id);
+
+  // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
+  Page *page = &pages_[frame_id];
+  page->page_id_ = page_id;
+  page->pin_count_ = 1;
+  replacer_->Pin(frame_id);
+
+  if (log_manager_ != nullptr) {
+    /* the page put aside is newer than the disk, it goes back into the pool and is written from there */
+    int index = FindDeferred(page_id);
+    if (index != -1) {
+      memcpy(page->GetData(), deferred_pages_ + static_cast<size_t>(index) * PAGE_SIZE, PAGE_SIZE);
+      memcpy(LoggedImage(frame_id), page->GetData(), PAGE_SIZE);
+      frame_lsns_[frame_id] = deferred_lsns_[index];
+      page->is_dirty_ = true;
+      RemoveDeferred(index);
+      WaitWriteBack(&write_back);
+      return page;
+    }
+  }
+
+  /* it would throw here, however, the page is still pinned, which needs further fixings */
+  try {
+    disk_manager_->ReadPage(page_id, page->GetData());
+  } catch (read_less_then_a_page &error) {
+    WaitWriteBack(&write_back);
+    throw;
+  }
+  WaitWriteBack(&write_back);
+  if (log_manager_ != nullptr) {
+    memcpy(LoggedImage(frame_id), page->GetData(), PAGE_SIZE);
+    frame_lsns_[frame_id] = INVALID_LSN;
+  }
+  return page;
+}
+
+bool BufferPoolManagerInstance::UnpinPage(page_id_t page_id, bool is_dirty) {
+  std::unique_lock<std::mutex> lock =
+      NeedLatch() ? std::unique_lock<std::mutex>(latch_) : std::unique_lock<std::mutex>();
+  //  std::scoped_lock lock{latch_};
+
+  /* whether it's in the buffer pool */
+  frame_id_t frame_id = page_table_.Find(page_id);
+  if (frame_id == -1) {
+    return false;
+  }
+
+  Page *page = &pages_[frame_id];
+
+  /* it's not pinned */
+  if (page->pin_count_ == 0) {
+    return false;
+  }
+
+  /* modify the metadata */
+  page->is_dirty_ |= is_dirty;
+  --page->pin_count_;
+  if (is_dirty && log_manager_ != nullptr && !is_changed_[frame_id]) {
+    is_changed_[frame_id] = true;
+    changed_frames_.push_back(frame_id);
+  }
+
+  /* maybe it becomes the unpinned page */
+  if (page->pin_count_ == 0) {
+    replacer_->Unpin(frame_id);
+  }
+
+  return true;
+}
+
+bool BufferPoolManagerInstance::FlushPage(page_id_t page_id) {
+  std::unique_lock<std::mutex> lock =
+      NeedLatch() ? std::unique_lock<std::mutex>(latch_) : std::unique_lock<std::mutex>();
+  //  std::scoped_lock lock{latch_};
+
+  /* invalid operation */
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  cleaned_cv_.wait(lock, [this, page_id] { return !IsPageCleaning(page_id); });
+
+  /* no exist in page table, cannot be flushed */
+  frame_id_t frame_id = page_table_.Find(page_id);
+  if (frame_id == -1) {
+    return false;
+  }
+
+  // Make sure you call DiskManager::WritePage!
+  Page *page = &pages_[frame_id];
+
+  /* flush whether it's dirty or not */
+  if (log_manager_ != nullptr) {
+    LogFrame(frame_id);
+    log_manager_->Flush(frame_lsns_[frame_id]);
+  }
+  disk_manager_->WritePage(page_id, page->GetData());
+  page->is_dirty_ = false;
+  return true;
+}
+
+Page *BufferPoolManagerInstance::NewPage(page_id_t *page_id) {
+  std::unique_lock<std::mutex> lock =
+      NeedLatch() ? std::unique_lock<std::mutex>(latch_) : std::unique_lock<std::mutex>();
+  //  std::scoped_lock lock{latch_};
+
+  // 0.   Make sure you call DiskManager::AllocatePage!
+  // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
+  if (IsNextVictimCleaning()) {
+    cleaned_cv_.wait(lock, [this] { return !IsNextVictimCleaning(); });
+  }
+  DiskRequest write_back;
+  frame_id_t frame_id = FindFrame(disk_manager_->IsAsyncPreferred() ? &write_back : nullptr);
+
+  // 1.   If all the pages in the buffer pool are pinned, return nullptr.
+  if (frame_id == -1) {
+    return nullptr;
+  }
+
+  // 3.   Update P's metadata, zero out memory and add P to the page table.
+  *page_id = AllocatePage();
+
+  // 4.   Set the page ID output parameter. Return a pointer to P.
+  return InstallPage(frame_id, *page_id, &write_back);
+}
+
+Page *BufferPoolManagerInstance::CreatePage(page_id_t page_id) {
+  std::unique_lock<std::mutex> lock =
+      NeedLatch() ? std::unique_lock<std::mutex>(latch_) : std::unique_lock<std::mutex>();
+
+  if (IsNextVictimCleaning()) {
+    cleaned_cv_.wait(lock, [this] { return !IsNextVictimCleaning(); });
+  }
+  DiskRequest write_back;
+  frame_id_t frame_id = FindFrame(disk_manager_->IsAsyncPreferred() ? &write_back : nullptr);
+  if (frame_id == -1) {
+    return nullptr;
+  }
+  return InstallPage(frame_id, page_id, &write_back);
+}
+
+Page *BufferPoolManagerInstance::InstallPage(frame_id_t frame_id, page_id_t page_id, DiskRequest *write_back) {
+  Page *page = &pages_[frame_id];
+
+  if (log_manager_ == nullptr) {
+    /* flush it */
+    disk_manager_->WritePage(page_id, page->GetData());
+  } else {
+    /* the zeroed page is logged against what's on disk, or against the freed page put aside, and is written back
+     * only after it's logged */
+    char *logged_image = LoggedImage(frame_id);
+    int index = FindDeferred(page_id);
+    frame_lsns_[frame_id] = INVALID_LSN;
+    if (index != -1) {
+      memcpy(logged_image, deferred_pages_ + static_cast<size_t>(index) * PAGE_SIZE, PAGE_SIZE);
+      frame_lsns_[frame_id] = deferred_lsns_[index];
+      RemoveDeferred(index);
+    } else {
+      memset(logged_image, 0, PAGE_SIZE);
+      try {
+        disk_manager_->ReadPage(page_id, logged_image);
+      } catch (read_less_then_a_page &error) {
+        /* a new page beyond the end of the file */
+      }
+    }
+    page->is_dirty_ = true;
+    if (!is_changed_[frame_id]) {
+      is_changed_[frame_id] = true;
+      changed_frames_.push_back(frame_id);
+    }
+  }
+  WaitWriteBack(write_back);
+
+  page->page_id_ = page_id;
+  page->pin_count_ = 1;
+  replacer_->Pin(frame_id);
+
+  /* update the page table */
+  page_table_.Insert(page_id, frame_id);
+  // printf("add %d with %d\n", frame_id, page_id);
+
+  return page;
+}
+
+bool BufferPoolManagerInstance::DeletePage(page_id_t page_id) {
+  std::unique_lock<std::mutex> lock =
+      NeedLatch() ? std::unique_lock<std::mutex>(latch_) : std::unique_lock<std::mutex>();
+  //  std::scoped_lock lock{latch_};
+
+  // 0.   Make sure you call DiskManager::DeallocatePage!
+  // 1.   Search the page table for the requested page (P).
+  cleaned_cv_.wait(lock, [this, page_id] { return !IsPageCleaning(page_id); });
+  frame_id_t frame_id = page_table_.Find(page_id);
+  if (frame_id == -1) {
+    // 1.   If P does not exist, return true.
+    /* it's only on disk, but its space is still given back */
+    if (log_manager_ != nullptr) {
+      DeferFreedPage(page_id, -1);
+    } else {
+      disk_manager_->DeallocatePage(page_id);
+    }
+    return true;
+  }
+  Page *page = &pages_[frame_id];
+
+  // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
+  if (page->GetPinCount() != 0) {
+    return false;
+  }
+
+  // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free
+
+  /* update the page table */
+  page_table_.Erase(page_id);
+
+  /* deallocate */
+  if (log_manager_ != nullptr) {
+    DeferFreedPage(page_id, frame_id);
+    is_changed_[frame_id] = false;
+  } else {
+    disk_manager_->DeallocatePage(page_id);
+  }
+
+  /* update metadata */
+  page->is_dirty_ = false;
+  page->page_id_ = INVALID_PAGE_ID;
+  page->pin_count_ = 0;
+
+  /* add it into the free list */
+  free_list_.push_back(static_cast<int>(frame_id));
+
+  /* modify the LRU queue */
+  replacer_->Pin(frame_id);
+
+  return true;
+}
+
+void BufferPoolManagerInstance::FlushAllPages() {
+  std::unique_lock<std::mutex> lock =
+      NeedLatch() ? std::unique_lock<std::mutex>(latch_) : std::unique_lock<std::mutex>();
+  //  std::scoped_lock lock{latch_};
+
+  cleaned_cv_.wait(lock, [this] { return cleaning_frame_id_ == -1; });
+  if (log_manager_ != nullptr) {
+    WriteDeferred();
+    /* all of them are logged first, then a single sync covers them */
+    lsn_t lsn = INVALID_LSN;
+    for (size_t frame_id = 0; frame_id < pool_size_; ++frame_id) {
+      if (pages_[frame_id].GetPageId() != INVALID_PAGE_ID) {
+        LogFrame(frame_id);
+        lsn = std::max(lsn, frame_lsns_[frame_id]);
+      }
+    }
+    log_manager_->Flush(lsn);
+  }
+  /* the frames in use are exactly those with a page id */
+  for (size_t frame_id = 0; frame_id < pool_size_; ++frame_id) {
+    Page *page = &pages_[frame_id];
+    if (page->GetPageId() == INVALID_PAGE_ID) {
+      continue;
+    }
+    disk_manager_->WritePage(page->GetPageId(), page->GetData());
+    page->is_dirty_ = false;
+    if (log_manager_ != nullptr) {
+      /* the page is on disk, none of its records has to be forced any more */
+      frame_lsns_[frame_id] = INVALID_LSN;
+    }
+  }
+}
+
+void BufferPoolManagerInstance::Initialize() {
+  std::unique_lock<std::mutex> lock =
+      NeedLatch() ? std::unique_lock<std::mutex>(latch_) : std::unique_lock<std::mutex>();
+  cleaned_cv_.wait(lock, [this] { return cleaning_frame_id_ == -1; });
+  replacer_->Clear();
+  page_table_.Clear();
+  free_list_.clear();
+
+  /* the pages are dropped, the page table would fill up with stale entries otherwise */
+  for (size_t i = 0; i < pool_size_; ++i) {
+    pages_[i].page_id_ = INVALID_PAGE_ID;
+    pages_[i].is_dirty_ = false;
+    pages_[i].pin_count_ = 0;
+    free_list_.push_back(static_cast<int>(i));
+    if (log_manager_ != nullptr) {
+      frame_lsns_[i] = INVALID_LSN;
+      is_changed_[i] = false;
+    }
+  }
+  changed_frames_.clear();
+  deferred_num_ = 0;
+}
+
+}  // namespace thomas
@@ -0,0 +1,76 @@
+#include "buffer/clock_replacer.h"
+
+namespace thomas {
+
+ClockReplacer::ClockReplacer(size_t num_pages) : num_pages_(num_pages) {
+  in_clock_ = new bool[num_pages_]();
+  reference_ = new bool[num_pages_]();
+}
+
+ClockReplacer::~ClockReplacer() {
+  delete[] in_clock_;
+  delete[] reference_;
+}
+
+bool ClockReplacer::Victim(frame_id_t *frame_id) {
+  if (size_ == 0) {
+    return false;
+  }
+
+  /* there must be a victim within two rounds */
+  while (true) {
+    size_t current = hand_;
+    hand_ = (hand_ + 1) % num_pages_;
+    if (!in_clock_[current]) {
+      continue;
+    }
+    if (reference_[current]) {
+      /* second chance */
+      reference_[current] = false;
+      continue;
+    }
+    in_clock_[current] = false;
+    --size_;
+    *frame_id = static_cast<frame_id_t>(current);
+    return true;
+  }
+}
+
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  /* it might can't be found */
+  if (in_clock_[frame_id]) {
+    in_clock_[frame_id] = false;
+    --size_;
+  }
+}
+
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  if (!in_clock_[frame_id]) {
+    in_clock_[frame_id] = true;
+    ++size_;
+  }
+  reference_[frame_id] = true;
+}
+
+void ClockReplacer::Candidates(size_t n, vector<frame_id_t> *frames) {
+  /* the first round takes the frames without reference bits, and the second round takes the rest */
+  for (int round = 0; round < 2; ++round) {
+    for (size_t i = 0; i < num_pages_ && frames->size() < n; ++i) {
+      size_t current = (hand_ + i) % num_pages_;
+      if (in_clock_[current] && reference_[current] == (round == 1)) {
+        frames->push_back(static_cast<frame_id_t>(current));
+      }
+    }
+  }
+}
+
+size_t ClockReplacer::Size() { return size_; }
+
+void ClockReplacer::Clear() {
+  for (size_t i = 0; i < num_pages_; ++i) {
+    in_clock_[i] = reference_[i] = false;
+  }
+  hand_ = size_ = 0;
+}
+
+}  // namespace thomas
@@ -4,57 +4,92 @@
 
 namespace thomas {
 
-InnodbReplacer::InnodbReplacer(size_t num_pages) : num_pages_(num_pages) {}
+InnodbReplacer::InnodbReplacer(size_t num_pages) : num_pages_(num_pages) {
+  access_count_ = new size_t[num_pages_]();
+}
 
-InnodbReplacer::~InnodbReplacer() = default;
+InnodbReplacer::~InnodbReplacer() { delete[] access_count_; }
 
 bool InnodbReplacer::Victim(frame_id_t *frame_id) {
-  if (left_half.empty() && right_half.empty()) {
+  if (left_half_.empty() && right_half_.empty()) {
     return false;
   }
 
-  /* there must be a victim */
-  *frame_id = left_half.begin()->second;
-  left_half.erase(left_half.begin());
+  /* there must be a victim, the old sublist is empty only when the young one is too small to be split */
+  if (!left_half_.empty()) {
+    *frame_id = left_half_.begin()->second;
+    left_half_.erase(left_half_.begin());
+  } else {
+    *frame_id = right_half_.begin()->second;
+    right_half_.erase(right_half_.begin());
+  }
+  access_count_[*frame_id] = 0;
   Adjust();
   return true;
 }
 
 void InnodbReplacer::Pin(frame_id_t frame_id) {
+  ++access_count_[frame_id];
+
   /* it might can't be found */
-  auto left_half_iter = left_half.find(frame_id);
-  if (left_half_iter != left_half.end()) {
-    left_half.erase(left_half_iter);
+  auto left_half_iter = left_half_.find(frame_id);
+  if (left_half_iter != left_half_.end()) {
+    left_half_.erase(left_half_iter);
     Adjust();
-  } else {
-    auto right_half_iter = right_half.find(frame_id);
-    if (right_half_iter != right_half.end()) {
-      right_half.erase(right_half_iter);
-    }
+    return;
+  }
+  auto right_half_iter = right_half_.find(frame_id);
+  if (right_half_iter != right_half_.end()) {
+    right_half_.erase(right_half_iter);
   }
 }
 
 void InnodbReplacer::Unpin(frame_id_t frame_id) {
   /* avoid being too large */
-  if (left_half.size() + right_half.size() >= num_pages_) {
+  if (left_half_.size() + right_half_.size() >= num_pages_) {
     return;
   }
 
   /* maybe it's existed, maybe it's not */
-  if (left_half.count(frame_id) == 0 && right_half.count(frame_id) == 0) {
-    right_half.front_insert(linked_hashmap<frame_id_t, frame_id_t>::value_type(frame_id, frame_id));
-    Adjust();
+  if (left_half_.count(frame_id) != 0 || right_half_.count(frame_id) != 0) {
+    return;
+  }
+  if (access_count_[frame_id] > 1) {
+    /* accessed again, it's young */
+    right_half_[frame_id] = frame_id;
+  } else {
+    /* inserted at the midpoint */
+    left_half_[frame_id] = frame_id;
+  }
+  Adjust();
+}
+
+void InnodbReplacer::Candidates(size_t n, vector<frame_id_t> *frames) {
+  /* a victim from the young sublist moves the next young frame into the old one, so the order is simply old, young */
+  for (auto iter = left_half_.begin(); iter != left_half_.end() && frames->size() < n; ++iter) {
+    frames->push_back(iter->second);
+  }
+  for (auto iter = right_half_.begin(); iter != right_half_.end() && frames->size() < n; ++iter) {
+    frames->push_back(iter->second);
   }
 }
 
 void InnodbReplacer::Adjust() {
-  while (left_half.size() * FACTOR < right_half.size()) {  // NOLINT
-    frame_id_t transfer = right_half.begin()->first;
-    left_half[transfer] = transfer;
-    right_half.erase(right_half.begin());
+  while (!right_half_.empty() && left_half_.size() < (left_half_.size() + right_half_.size()) * factor_) {
+    frame_id_t transfer = right_half_.begin()->first;
+    left_half_[transfer] = transfer;
+    right_half_.erase(right_half_.begin());
   }
 }
 
-size_t InnodbReplacer::Size() { return left_half.size() + right_half.size(); }
+size_t InnodbReplacer::Size() { return left_half_.size() + right_half_.size(); }
+
+void InnodbReplacer::Clear() {
+  left_half_.clear();
+  right_half_.clear();
+  for (size_t i = 0; i < num_pages_; ++i) {
+    access_count_[i] = 0;
+  }
+}
 
 }  // namespace thomas
@@ -0,0 +1,92 @@
+#include "buffer/lru_k_replacer.h"
+
+namespace thomas {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages) : num_pages_(num_pages) {
+  evictable_ = new bool[num_pages_]();
+  last_ = new size_t[num_pages_]();
+  second_last_ = new size_t[num_pages_]();
+}
+
+LRUKReplacer::~LRUKReplacer() {
+  delete[] evictable_;
+  delete[] last_;
+  delete[] second_last_;
+}
+
+bool LRUKReplacer::Before(size_t a, size_t b) const {
+  /* the frames without a second pin have an infinite backward distance, and the ties go to plain LRU */
+  if (second_last_[a] != second_last_[b]) {
+    return second_last_[a] < second_last_[b];
+  }
+  return last_[a] < last_[b];
+}
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  if (size_ == 0) {
+    return false;
+  }
+
+  size_t victim = num_pages_;
+  for (size_t i = 0; i < num_pages_; ++i) {
+    if (evictable_[i] && (victim == num_pages_ || Before(i, victim))) {
+      victim = i;
+    }
+  }
+
+  /* the history goes with the page */
+  evictable_[victim] = false;
+  last_[victim] = second_last_[victim] = 0;
+  --size_;
+  *frame_id = static_cast<frame_id_t>(victim);
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  second_last_[frame_id] = last_[frame_id];
+  last_[frame_id] = ++current_timestamp_;
+
+  /* it might can't be found */
+  if (evictable_[frame_id]) {
+    evictable_[frame_id] = false;
+    --size_;
+  }
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  if (!evictable_[frame_id]) {
+    evictable_[frame_id] = true;
+    ++size_;
+  }
+}
+
+void LRUKReplacer::Candidates(size_t n, vector<frame_id_t> *frames) {
+  /* selection of the n first victims, n is the small cleaner watermark */
+  size_t last_taken = num_pages_;
+  while (frames->size() < n) {
+    size_t next = num_pages_;
+    for (size_t i = 0; i < num_pages_; ++i) {
+      if (evictable_[i] && (last_taken == num_pages_ || Before(last_taken, i)) &&
+          (next == num_pages_ || Before(i, next))) {
+        next = i;
+      }
+    }
+    if (next == num_pages_) {
+      return;
+    }
+    frames->push_back(static_cast<frame_id_t>(next));
+    last_taken = next;
+  }
+}
+
+size_t LRUKReplacer::Size() { return size_; }
+
+void LRUKReplacer::Clear() {
+  for (size_t i = 0; i < num_pages_; ++i) {
+    evictable_[i] = false;
+    last_[i] = second_last_[i] = 0;
+  }
+  size_ = 0;
+}
+
+}  // namespace thomas
@@ -39,6 +39,12 @@ void LRUReplacer::Unpin(frame_id_t frame_id) {
   queue_[frame_id] = frame_id;
 }
 
+void LRUReplacer::Candidates(size_t n, vector<frame_id_t> *frames) {
+  for (auto iter = queue_.begin(); iter != queue_.end() && frames->size() < n; ++iter) {
+    frames->push_back(iter->second);
+  }
+}
+
 size_t LRUReplacer::Size() { return queue_.size(); }
 
 void LRUReplacer::Clear() { queue_.clear(); }
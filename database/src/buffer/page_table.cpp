@@ -0,0 +1,68 @@
+#include "buffer/page_table.h"
+
+namespace thomas {
+
+PageTable::PageTable(size_t num_frames) {
+  /* at most half full, so that the probes stay short */
+  size_t bits = 1;
+  while ((static_cast<size_t>(1) << bits) < num_frames * 2) {
+    ++bits;
+  }
+  capacity_ = static_cast<size_t>(1) << bits;
+  mask_ = capacity_ - 1;
+  shift_ = 32 - bits;
+  keys_ = new page_id_t[capacity_];
+  values_ = new frame_id_t[capacity_];
+  Clear();
+}
+
+PageTable::~PageTable() {
+  delete[] keys_;
+  delete[] values_;
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  size_t slot = Slot(page_id);
+  while (keys_[slot] != INVALID_PAGE_ID && keys_[slot] != page_id) {
+    slot = (slot + 1) & mask_;
+  }
+  if (keys_[slot] == INVALID_PAGE_ID) {
+    keys_[slot] = page_id;
+    ++size_;
+  }
+  values_[slot] = frame_id;
+}
+
+bool PageTable::Erase(page_id_t page_id) {
+  size_t slot = Slot(page_id);
+  while (keys_[slot] != page_id) {
+    if (keys_[slot] == INVALID_PAGE_ID) {
+      return false;
+    }
+    slot = (slot + 1) & mask_;
+  }
+
+  /* backward shift: move up every later entry of the run that may sit in the hole */
+  size_t hole = slot;
+  for (size_t next = (hole + 1) & mask_; keys_[next] != INVALID_PAGE_ID; next = (next + 1) & mask_) {
+    size_t home = Slot(keys_[next]);
+    /* the entry can't move if its home lies cyclically in (hole, next] */
+    if (((next - home) & mask_) >= ((next - hole) & mask_)) {
+      keys_[hole] = keys_[next];
+      values_[hole] = values_[next];
+      hole = next;
+    }
+  }
+  keys_[hole] = INVALID_PAGE_ID;
+  --size_;
+  return true;
+}
+
+void PageTable::Clear() {
+  for (size_t i = 0; i < capacity_; ++i) {
+    keys_[i] = INVALID_PAGE_ID;
+  }
+  size_ = 0;
+}
+
+}  // namespace thomas
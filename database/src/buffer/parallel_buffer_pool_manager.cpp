@@ -0,0 +1,90 @@
+#include "buffer/parallel_buffer_pool_manager.h"
+
+namespace thomas {
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size,
+                                                     DiskManager *disk_manager, THREAD_SAFE_TYPE ts_type,
+                                                     REPLACER_TYPE replacer_type)
+    : num_instances_(num_instances), disk_manager_(disk_manager) {
+  /* the first pool_size % num_instances instances get one more frame */
+  for (size_t i = 0; i < num_instances_; ++i) {
+    size_t instance_size = pool_size / num_instances_ + (i < pool_size % num_instances_ ? 1 : 0);
+    instances_.push_back(new BufferPoolManagerInstance(instance_size, disk_manager_, ts_type, replacer_type));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  for (size_t i = 0; i < num_instances_; ++i) {
+    delete instances_[i];
+  }
+}
+
+size_t ParallelBufferPoolManager::GetPoolSize() {
+  size_t pool_size = 0;
+  for (size_t i = 0; i < num_instances_; ++i) {
+    pool_size += instances_[i]->GetPoolSize();
+  }
+  return pool_size;
+}
+
+BufferPoolManagerInstance *ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) {
+  return instances_[static_cast<size_t>(page_id) % num_instances_];
+}
+
+Page *ParallelBufferPoolManager::FetchPage(page_id_t page_id) {
+  return GetBufferPoolManager(page_id)->FetchPage(page_id);
+}
+
+bool ParallelBufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
+  return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+bool ParallelBufferPoolManager::FlushPage(page_id_t page_id) {
+  /* invalid operation */
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->FlushPage(page_id);
+}
+
+Page *ParallelBufferPoolManager::NewPage(page_id_t *page_id) {
+  /* the allocation is atomic, so only the owning instance is latched */
+  page_id_t new_page_id = disk_manager_->AllocatePage();
+  Page *page = GetBufferPoolManager(new_page_id)->CreatePage(new_page_id);
+  if (page == nullptr) {
+    disk_manager_->DeallocatePage(new_page_id);
+    return nullptr;
+  }
+  *page_id = new_page_id;
+  return page;
+}
+
+bool ParallelBufferPoolManager::DeletePage(page_id_t page_id) {
+  return GetBufferPoolManager(page_id)->DeletePage(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPages() {
+  for (size_t i = 0; i < num_instances_; ++i) {
+    instances_[i]->FlushAllPages();
+  }
+}
+
+void ParallelBufferPoolManager::Initialize() {
+  for (size_t i = 0; i < num_instances_; ++i) {
+    instances_[i]->Initialize();
+  }
+}
+
+void ParallelBufferPoolManager::StartCleaner(size_t watermark) {
+  for (size_t i = 0; i < num_instances_; ++i) {
+    instances_[i]->StartCleaner(watermark);
+  }
+}
+
+void ParallelBufferPoolManager::StopCleaner() {
+  for (size_t i = 0; i < num_instances_; ++i) {
+    instances_[i]->StopCleaner();
+  }
+}
+
+}  // namespace thomas
@@ -1,52 +1,28 @@
 #pragma once
 
-#include <mutex>  // NOLINT
-
-#include "buffer/lru_replacer.h"
-#include "container/linked_hashmap.hpp"
-#include "container/vector.hpp"
-#include "storage/disk/disk_manager.h"
+#include "common/config.h"
 #include "storage/page/page.h"
-#include "thread/thread_safe.h"
 
 namespace thomas {
 
 /**
- * BufferPoolManager reads disk pages to and from its internal buffer pool.
+ * BufferPoolManager is the interface the B+ trees see, implemented by a single BufferPoolManagerInstance, or by a
+ * ParallelBufferPoolManager sharding the pages among several instances.
  */
 class BufferPoolManager {
  public:
-  enum class CallbackType { BEFORE, AFTER };
-  using bufferpool_callback_fn = void (*)(enum CallbackType, const page_id_t page_id);
-
-  /**
-   * Creates a new BufferPoolManager.
-   * @param pool_size the size of the buffer pool
-   * @param disk_manager the disk manager
-   * @param log_manager the log manager (for testing only: nullptr = disable logging)
-   */
-  BufferPoolManager(size_t pool_size, DiskManager *disk_manager,
-                    THREAD_SAFE_TYPE ts_type = THREAD_SAFE_TYPE::NON_THREAD_SAFE);
-
-  /**
-   * Destroys an existing BufferPoolManager.
-   */
-  ~BufferPoolManager();
-
-  size_t Size() { return free_list_.size() + replacer_->Size(); }
-
-  /** @return pointer to all the pages in the buffer pool */
-  Page *GetPages() { return pages_; }
+  BufferPoolManager() = default;
+  virtual ~BufferPoolManager() = default;
 
   /** @return size of the buffer pool */
-  size_t GetPoolSize() { return pool_size_; }
+  virtual size_t GetPoolSize() = 0;
 
   /**
    * Fetch the requested page from the buffer pool.
    * @param page_id id of page to be fetched
    * @return the requested page
    */
-  Page *FetchPage(page_id_t page_id);
+  virtual Page *FetchPage(page_id_t page_id) = 0;
 
   /**
    * Unpin the target page from the buffer pool.
@@ -54,70 +30,57 @@ class BufferPoolManager {
    * @param is_dirty true if the page should be marked as dirty, false otherwise
    * @return false if the page pin count is <= 0 before this call, true otherwise
    */
-  bool UnpinPage(page_id_t page_id, bool is_dirty);
+  virtual bool UnpinPage(page_id_t page_id, bool is_dirty) = 0;
 
   /**
    * Flushes the target page to disk.
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
    * @return false if the page could not be found in the page table, true otherwise
    */
-  bool FlushPage(page_id_t page_id);
+  virtual bool FlushPage(page_id_t page_id) = 0;
 
   /**
    * Creates a new page in the buffer pool.
    * @param[out] page_id id of created page
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
-  Page *NewPage(page_id_t *page_id);
+  virtual Page *NewPage(page_id_t *page_id) = 0;
 
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
    * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
    */
-  bool DeletePage(page_id_t page_id);
+  virtual bool DeletePage(page_id_t page_id) = 0;
 
   /**
    * Flushes all the pages in the buffer pool to disk.
    */
-  void FlushAllPages();
+  virtual void FlushAllPages() = 0;
 
   /**
    * @brief
    * Initialize the buffer pool
    */
-  void Initialize();
+  virtual void Initialize() = 0;
 
   /**
    * @brief
-   * Whether the algorithm is thread-safe.
+   * Log the pages changed since they were last logged, called at a commit. Nothing is done without a log manager.
    */
-  bool IsThreadSafe() { return ts_type_ == THREAD_SAFE_TYPE::THREAD_SAFE; }
+  virtual void LogDirtyPages() {}
 
- protected:
   /**
    * @brief
-   * Try to find an empty frame for later use.
-   * @return frame_id_t for the particular frame.
-   * @return -1 is none is available.
+   * Start the page cleaner, see BufferPoolManagerInstance::StartCleaner.
+   * @param watermark how many frames at the victim end should be kept clean
    */
-  frame_id_t FindFrame();
+  virtual void StartCleaner(size_t watermark = CLEANER_WATERMARK) = 0;
 
-  /** Number of pages in the buffer pool. */
-  size_t pool_size_;
-  /** Array of buffer pool pages. */
-  Page *pages_;
-  /** Pointer to the disk manager. */
-  DiskManager *disk_manager_;
-  /** Page table for keeping track of buffer pool pages. */
-  linked_hashmap<page_id_t, frame_id_t> page_table_;
-  /** Replacer to find unpinned pages for replacement. */
-  Replacer *replacer_;
-  /** List of free pages. */
-  vector<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
-  std::mutex latch_;
-  /** Whether it needs to be thread safe*/
-  THREAD_SAFE_TYPE ts_type_;
+  /**
+   * @brief
+   * Stop the page cleaner.
+   */
+  virtual void StopCleaner() = 0;
 };
 }  // namespace thomas
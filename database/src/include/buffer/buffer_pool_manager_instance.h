@@ -0,0 +1,272 @@
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#include <thread>              // NOLINT
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/page_table.h"
+#include "buffer/replacer.h"
+#include "container/vector.hpp"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+#include "thread/thread_safe.h"
+
+namespace thomas {
+
+/**
+ * BufferPoolManagerInstance reads disk pages to and from its internal buffer pool.
+ */
+class BufferPoolManagerInstance : public BufferPoolManager {
+ public:
+  enum class CallbackType { BEFORE, AFTER };
+  using bufferpool_callback_fn = void (*)(enum CallbackType, const page_id_t page_id);
+
+  /**
+   * Creates a new BufferPoolManagerInstance.
+   * @param pool_size the size of the buffer pool
+   * @param disk_manager the disk manager
+   * @param ts_type whether the buffer pool is latched
+   * @param replacer_type the replacement policy
+   */
+  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
+                            THREAD_SAFE_TYPE ts_type = THREAD_SAFE_TYPE::NON_THREAD_SAFE,
+                            REPLACER_TYPE replacer_type = REPLACER_TYPE::LRU);
+
+  /**
+   * Destroys an existing BufferPoolManagerInstance.
+   */
+  ~BufferPoolManagerInstance() override;
+
+  size_t Size() { return free_list_.size() + replacer_->Size(); }
+
+  /** @return pointer to all the pages in the buffer pool */
+  Page *GetPages() { return pages_; }
+
+  /** @return size of the buffer pool */
+  size_t GetPoolSize() override { return pool_size_; }
+
+  /**
+   * Fetch the requested page from the buffer pool.
+   * @param page_id id of page to be fetched
+   * @return the requested page
+   */
+  Page *FetchPage(page_id_t page_id) override;
+
+  /**
+   * Unpin the target page from the buffer pool.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  bool UnpinPage(page_id_t page_id, bool is_dirty) override;
+
+  /**
+   * Flushes the target page to disk.
+   * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
+   * @return false if the page could not be found in the page table, true otherwise
+   */
+  bool FlushPage(page_id_t page_id) override;
+
+  /**
+   * Creates a new page in the buffer pool.
+   * @param[out] page_id id of created page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPage(page_id_t *page_id) override;
+
+  /**
+   * Deletes a page from the buffer pool.
+   * @param page_id id of page to be deleted
+   * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+   */
+  bool DeletePage(page_id_t page_id) override;
+
+  /**
+   * Brings a page allocated by the caller into the buffer pool as a zeroed page, used by the parallel buffer pool
+   * which allocates the page id before picking the instance owning it.
+   * @param page_id id of the page, already allocated from the disk manager
+   * @return nullptr if all the pages are pinned, otherwise pointer to the page
+   */
+  Page *CreatePage(page_id_t page_id);
+
+  /**
+   * Flushes all the pages in the buffer pool to disk.
+   */
+  void FlushAllPages() override;
+
+  /**
+   * @brief
+   * Initialize the buffer pool
+   */
+  void Initialize() override;
+
+  /**
+   * @brief
+   * Whether the algorithm is thread-safe.
+   */
+  bool IsThreadSafe() { return ts_type_ == THREAD_SAFE_TYPE::THREAD_SAFE; }
+
+  /**
+   * @brief
+   * Start the page cleaner, a background thread writing back the dirty frames among the next watermark victims, so
+   * that evictions find clean frames. The buffer pool is latched while it's running, even in NON_THREAD_SAFE mode, so
+   * call it before the buffer pool is used.
+   * @param watermark how many frames at the victim end should be kept clean
+   */
+  void StartCleaner(size_t watermark = CLEANER_WATERMARK) override;
+
+  /**
+   * @brief
+   * Stop the page cleaner, called by the destructor.
+   */
+  void StopCleaner() override;
+
+  /**
+   * @brief
+   * Log the pages of the file to the write-ahead log. Each frame keeps its image as of its last record, so that a
+   * record holds only the bytes changed since, and a page is written back only after the log is on disk up to its last
+   * record. Call it before the buffer pool is used.
+   * @param log_manager the log manager
+   * @param file_id the id of the file in the log, given by LogManager::RegisterFile
+   */
+  void SetLogManager(LogManager *log_manager, int file_id);
+
+  /**
+   * @brief
+   * Log the pages unpinned as dirty since the last call, called at a commit.
+   */
+  void LogDirtyPages() override;
+
+ protected:
+  /**
+   * @brief
+   * Try to find an empty frame for later use.
+   * @param[out] write_back if it's not nullptr, a dirty victim is copied out and written asynchronously, and the
+   * caller should wait for it when write_back->data_ is not nullptr; otherwise it's written synchronously
+   * @return frame_id_t for the particular frame.
+   * @return -1 is none is available.
+   */
+  frame_id_t FindFrame(DiskRequest *write_back = nullptr);
+
+  /** The latch is needed by THREAD_SAFE mode, and by the cleaner. */
+  bool NeedLatch() { return IsThreadSafe() || cleaner_running_; }
+
+  void CleanerFunction();
+
+  /** @return whether FindFrame would pick the frame the cleaner is writing */
+  bool IsNextVictimCleaning();
+
+  /** @return whether the page is in the frame the cleaner is writing */
+  bool IsPageCleaning(page_id_t page_id);
+
+  /**
+   * @brief
+   * Wait for the write-back started by FindFrame, if any.
+   */
+  void WaitWriteBack(DiskRequest *write_back);
+
+  /**
+   * @brief
+   * Write the zeroed frame found by FindFrame as the page, and pin it in the page table. The latch should be held.
+   */
+  Page *InstallPage(frame_id_t frame_id, page_id_t page_id, DiskRequest *write_back);
+
+  /** @return the image of the frame as of its last log record */
+  char *LoggedImage(frame_id_t frame_id) { return logged_images_ + static_cast<size_t>(frame_id) * PAGE_SIZE; }
+
+  /**
+   * @brief
+   * Log the changes of the frame since its last record. The latch should be held.
+   * @param is_undoable false at a commit, when the old bytes are not needed
+   */
+  void LogFrame(frame_id_t frame_id, bool is_undoable = true);
+
+  /**
+   * @brief
+   * Log a dirty victim and write it back once the log is on disk up to its last record. If it isn't yet, the page is
+   * put aside and written later with the others put aside, after a single sync, and a fetch in the meantime takes it
+   * from there. The latch should be held.
+   */
+  void DeferWrite(frame_id_t frame_id);
+
+  /**
+   * @brief
+   * Sync the log for the pages put aside and write them back. The latch should be held.
+   */
+  void WriteDeferred();
+
+  /** @return the index of the page among those put aside, -1 for none */
+  int FindDeferred(page_id_t page_id);
+
+  /** @brief forget a page put aside */
+  void RemoveDeferred(int index);
+
+  /**
+   * @brief
+   * Log the link written into a freed page and put the page aside, so it's written back with the victims instead of
+   * syncing the log on every free. The page is diffed against its logged image, or against the disk if it's not in
+   * the pool. The latch should be held.
+   * @param frame_id the frame of the page, -1 for none
+   */
+  void DeferFreedPage(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * @brief
+   * Allocate a page on disk. The head of the freed pages may be put aside, then its link is read from there. The
+   * latch should be held.
+   */
+  page_id_t AllocatePage();
+
+  /** Number of pages in the buffer pool. */
+  size_t pool_size_;
+  /** Array of buffer pool pages. */
+  Page *pages_;
+  /** Pointer to the disk manager. */
+  DiskManager *disk_manager_;
+  /** Page table for keeping track of buffer pool pages. */
+  PageTable page_table_;
+  /** Replacer to find unpinned pages for replacement. */
+  Replacer *replacer_;
+  /** List of free pages. */
+  vector<frame_id_t> free_list_;
+  /** Copy of the victim being written back, so that its frame can be reused at once. */
+  char *write_back_buffer_;
+  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  std::mutex latch_;
+  /** Whether it needs to be thread safe*/
+  THREAD_SAFE_TYPE ts_type_;
+
+  /** The page cleaner, all of the following are protected by latch_. */
+  std::thread cleaner_;
+  bool cleaner_running_{false};
+  bool cleaner_terminated_{false};
+  size_t cleaner_watermark_{0};
+  /** The frame whose copy is being written, -1 for none. */
+  frame_id_t cleaning_frame_id_{-1};
+  char *clean_buffer_{nullptr};
+  /** Wakes up the cleaner. */
+  std::condition_variable cleaner_cv_;
+  /** Notified when a frame is written by the cleaner. */
+  std::condition_variable cleaned_cv_;
+
+  /** The write-ahead log, nullptr if the pages are not logged. All of the following are protected by latch_. */
+  LogManager *log_manager_{nullptr};
+  int file_id_{-1};
+  /** The image of each frame as of its last log record. */
+  char *logged_images_{nullptr};
+  /** The LSN of the last record of each frame, INVALID_LSN for none since the frame was read. */
+  lsn_t *frame_lsns_{nullptr};
+  /** Whether each frame is unpinned as dirty since its last record, and the frames that are. */
+  bool *is_changed_{nullptr};
+  vector<frame_id_t> changed_frames_;
+  /** The old and the new image of a freed page. */
+  char *freed_images_{nullptr};
+  /** The victims put aside until the log is on disk up to their last records. */
+  char *deferred_pages_{nullptr};
+  page_id_t deferred_page_ids_[DEFERRED_WRITE_SIZE];
+  lsn_t deferred_lsns_[DEFERRED_WRITE_SIZE];
+  int deferred_num_{0};
+};
+}  // namespace thomas
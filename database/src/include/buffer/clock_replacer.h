@@ -0,0 +1,47 @@
+#pragma once
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace thomas {
+
+/**
+ * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy with a
+ * reference bit per frame. Everything is an array indexed by the frame id, so Pin and Unpin don't hash.
+ */
+class ClockReplacer : public Replacer {
+ public:
+  /**
+   * Create a new ClockReplacer.
+   * @param num_pages the maximum number of pages the ClockReplacer will be required to store
+   */
+  explicit ClockReplacer(size_t num_pages);
+
+  /**
+   * Destroys the ClockReplacer.
+   */
+  ~ClockReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void Candidates(size_t n, vector<frame_id_t> *frames) override;
+
+  size_t Size() override;
+
+  void Clear() override;
+
+ private:
+  /* whether the frame is in the clock, i.e. unpinned */
+  bool *in_clock_;
+  /* the reference bit, set when the frame is unpinned and cleared when the hand passes */
+  bool *reference_;
+  size_t hand_{0};
+  size_t size_{0};
+  size_t num_pages_;
+};
+
+}  // namespace thomas
@@ -10,20 +10,24 @@
 namespace thomas {
 
 /**
- * LRUReplacer implements the lru replacement policy, which approximates the Least Recently Used policy.
+ * InnodbReplacer implements the midpoint insertion of InnoDB. The frames are split into an old sublist at the victim
+ * end and a young sublist. A frame unpinned for the first time since it's loaded goes into the old sublist, and only
+ * a frame pinned again gets into the young one, so that a long scan only goes through the old sublist and leaves the
+ * hot pages alone.
  */
 class InnodbReplacer : public Replacer {
-  const double factor_ = 1.0 / 32;
+  /* the share of the old sublist */
+  const double factor_ = 3.0 / 8;
 
  public:
   /**
-   * Create a new LRUReplacer.
-   * @param num_pages the maximum number of pages the LRUReplacer will be required to store
+   * Create a new InnodbReplacer.
+   * @param num_pages the maximum number of pages the InnodbReplacer will be required to store
    */
   explicit InnodbReplacer(size_t num_pages);
 
   /**
-   * Destroys the LRUReplacer.
+   * Destroys the InnodbReplacer.
    */
   ~InnodbReplacer() override;
 
@@ -33,13 +37,20 @@ class InnodbReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  void Candidates(size_t n, vector<frame_id_t> *frames) override;
+
   size_t Size() override;
 
+  void Clear() override;
+
  private:
+  /** Move the least recent young frames into the old sublist until it has its share. */
   void Adjust();
 
+  /* the old sublist and the young sublist, the least recent first */
   linked_hashmap<frame_id_t, frame_id_t> left_half_, right_half_;
-  std::mutex latch_;
+  /* how many times the frame is pinned since it's loaded */
+  size_t *access_count_;
   size_t num_pages_;
 };
 
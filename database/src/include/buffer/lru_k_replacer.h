@@ -0,0 +1,53 @@
+#pragma once
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace thomas {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy with K = 2: the victim is the frame whose second most recent
+ * pin is the oldest, and frames pinned only once since they're loaded go first. A page touched once by a scan is
+ * thus evicted before an inner page touched by every search. The victim is found by a linear scan over the frames,
+ * which is cheap for the small pools used here.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   */
+  explicit LRUKReplacer(size_t num_pages);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void Candidates(size_t n, vector<frame_id_t> *frames) override;
+
+  size_t Size() override;
+
+  void Clear() override;
+
+ private:
+  /** @return whether frame a should be victimized before frame b */
+  bool Before(size_t a, size_t b) const;
+
+  /* whether the frame is unpinned */
+  bool *evictable_;
+  /* the most recent pin and the one before it, 0 for none */
+  size_t *last_;
+  size_t *second_last_;
+  size_t current_timestamp_{0};
+  size_t size_{0};
+  size_t num_pages_;
+};
+
+}  // namespace thomas
@@ -31,6 +31,8 @@ class LRUReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  void Candidates(size_t n, vector<frame_id_t> *frames) override;
+
   size_t Size() override;
 
   void Clear() override;
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace thomas {
+
+/**
+ * PageTable maps the page ids in a buffer pool to their frames. It's open-addressed with linear probing in one flat
+ * array of a power-of-two size, at least twice the number of frames, so it never grows and never allocates after
+ * construction. The dense page ids are scattered by a multiplicative hash, which also keeps the ids of one instance
+ * of a parallel buffer pool, a multiple of the number of instances apart, from piling up.
+ */
+class PageTable {
+ public:
+  /**
+   * Create a new PageTable.
+   * @param num_frames the number of frames, i.e. the most entries it will hold
+   */
+  explicit PageTable(size_t num_frames);
+
+  ~PageTable();
+
+  /** @return the frame holding the page, -1 if it's not in the table */
+  frame_id_t Find(page_id_t page_id) const {
+    for (size_t slot = Slot(page_id);; slot = (slot + 1) & mask_) {
+      if (keys_[slot] == page_id) {
+        return values_[slot];
+      }
+      if (keys_[slot] == INVALID_PAGE_ID) {
+        return -1;
+      }
+    }
+  }
+
+  /**
+   * @brief
+   * Insert the page, or update its frame if it's already there.
+   */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * @brief
+   * Remove the page, the entries after it in the same run are shifted back, so that no tombstone is left.
+   * @return false if the page is not in the table
+   */
+  bool Erase(page_id_t page_id);
+
+  size_t Size() const { return size_; }
+
+  void Clear();
+
+ private:
+  size_t Slot(page_id_t page_id) const {
+    /* the high bits of the product, Fibonacci hashing */
+    return static_cast<size_t>((static_cast<uint32_t>(page_id) * 2654435769U) >> shift_);
+  }
+
+  page_id_t *keys_;
+  frame_id_t *values_;
+  size_t capacity_;
+  size_t mask_;
+  size_t shift_;
+  size_t size_{0};
+};
+
+}  // namespace thomas
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "container/vector.hpp"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+#include "thread/thread_safe.h"
+
+namespace thomas {
+
+/**
+ * ParallelBufferPoolManager shards the pages among several BufferPoolManagerInstances by page_id % num_instances,
+ * each with its own latch, so that threads working on different pages don't wait for a single buffer pool latch.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * Creates a new ParallelBufferPoolManager.
+   * @param num_instances the number of individual BufferPoolManagerInstances
+   * @param pool_size the size of the whole buffer pool, shared evenly among the instances
+   * @param disk_manager the disk manager shared by the instances
+   * @param replacer_type the replacement policy of each instance
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                            THREAD_SAFE_TYPE ts_type = THREAD_SAFE_TYPE::THREAD_SAFE,
+                            REPLACER_TYPE replacer_type = REPLACER_TYPE::LRU);
+
+  /**
+   * Destroys an existing ParallelBufferPoolManager.
+   */
+  ~ParallelBufferPoolManager() override;
+
+  /** @return size of the buffer pool */
+  size_t GetPoolSize() override;
+
+  /** @return the instance responsible for the page */
+  BufferPoolManagerInstance *GetBufferPoolManager(page_id_t page_id);
+
+  Page *FetchPage(page_id_t page_id) override;
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty) override;
+
+  bool FlushPage(page_id_t page_id) override;
+
+  /**
+   * Creates a new page, the page id is allocated first, and the page goes into the instance owning it.
+   * @param[out] page_id id of created page
+   * @return nullptr if the owning instance has all its pages pinned, otherwise pointer to new page
+   */
+  Page *NewPage(page_id_t *page_id) override;
+
+  bool DeletePage(page_id_t page_id) override;
+
+  void FlushAllPages() override;
+
+  void Initialize() override;
+
+  /**
+   * @brief
+   * Start a page cleaner in each of the instances.
+   * @param watermark how many frames at the victim end of each instance should be kept clean
+   */
+  void StartCleaner(size_t watermark = CLEANER_WATERMARK) override;
+
+  void StopCleaner() override;
+
+ private:
+  size_t num_instances_;
+  DiskManager *disk_manager_;
+  vector<BufferPoolManagerInstance *> instances_;
+};
+}  // namespace thomas
@@ -1,9 +1,13 @@
 #pragma once
 
 #include "common/config.h"
+#include "container/vector.hpp"
 
 namespace thomas {
 
+/** The replacement policies a buffer pool can be constructed with. */
+enum class REPLACER_TYPE { LRU, INNODB, CLOCK, LRU_K };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -31,6 +35,13 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Peek at the frames that would be victimized next, without removing them.
+   * @param n the number of frames wanted
+   * @param[out] frames the first n frames in victim order, or all of them if there are fewer
+   */
+  virtual void Candidates(size_t n, vector<frame_id_t> *frames) = 0;
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
 
@@ -13,6 +13,13 @@ static constexpr int PAGE_SIZE = 32768;                                       //
 static constexpr int BUFFER_POOL_SIZE = 96;                                   // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr int DIRECT_IO_ALIGNMENT = 4096;                              // alignment of O_DIRECT buffers
+static constexpr int CLEANER_WATERMARK = 16;                                  // clean frames kept by the page cleaner
+static constexpr int CLEANER_INTERVAL = 50;                                   // idle period of the page cleaner in ms
+static constexpr int SWIZZLE_CAPACITY = 16;                                   // inner pages kept swizzled by a B+ tree
+static constexpr int DEFERRED_WRITE_SIZE = 16;                                // victims waiting for the log per pool
+static constexpr int LOG_TIMEOUT = 50;                                        // longest delay of a commit's sync in ms
+static constexpr int LOG_CHECKPOINT_SIZE = (64 << 20);                        // log size in byte for a checkpoint
 
 using int32_t = int;
 using uint16_t = unsigned short;  // NOLINT
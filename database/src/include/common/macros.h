@@ -2,6 +2,7 @@
 
 #include "Account.h"
 #include "TrainSystem.h"
+#include "common/rid.h"
 #include "type/dual_string.h"
 #include "type/string_any.h"
 #include "type/string_int_int.h"
@@ -21,6 +22,8 @@ namespace thomas {
   template class class_name<String<32>, User, StringComparator<32>>;                     /* NOLINT */ \
   template class class_name<String<24>, Train, StringComparator<24>>;                    /* NOLINT */ \
   template class class_name<String<32>, Train, StringComparator<32>>;                    /* NOLINT */ \
+  template class class_name<String<32>, int, StringComparator<32>>;                      /* NOLINT */ \
+  template class class_name<String<24>, TrainRoute, StringComparator<24>>;               /* NOLINT */ \
   template class class_name<DualString<32, 24>, Station, DualStringComparator<32, 24>>;  /* NOLINT */ \
   template class class_name<DualString<32, 32>, Station, DualStringComparator<32, 32>>;  /* NOLINT */ \
   template class class_name<StringAny<24, int>, DayTrain, StringAnyComparator<24, int>>; /* NOLINT */ \
@@ -28,7 +31,13 @@ namespace thomas {
   template class class_name<StringAny<24, int>, Order, StringAnyComparator<24, int>>;    /* NOLINT */ \
   template class class_name<StringAny<32, int>, Order, StringAnyComparator<32, int>>;    /* NOLINT */ \
   template class class_name<StringIntInt<24>, PendingOrder, StringIntIntComparator<24>>; /* NOLINT */ \
-  template class class_name<StringIntInt<32>, PendingOrder, StringIntIntComparator<32>>; /* NOLINT */
+  template class class_name<StringIntInt<32>, PendingOrder, StringIntIntComparator<32>>; /* NOLINT */ \
+  template class class_name<String<24>, RID, StringComparator<24>>;                      /* NOLINT */ \
+  template class class_name<StringAny<24, int>, RID, StringAnyComparator<24, int>>;      /* NOLINT */
+
+#define DECLARE_HEAP(class_name)                                                                   \
+  template class class_name<String<24>, Train, StringComparator<24>>;                 /* NOLINT */ \
+  template class class_name<StringAny<24, int>, Order, StringAnyComparator<24, int>>; /* NOLINT */
 
 #define DECLARE_BPLUSTREE_INTERNALPAGE(class_name)                                                     \
   template class class_name<String<24>, page_id_t, StringComparator<24>>;                 /* NOLINT */ \
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "common/config.h"
+
+namespace thomas {
+
+/**
+ * RID is the id of a record in a table heap: the page holding it and its slot in the page. It's stored in the B+ tree
+ * leaves in place of the record itself, so it stays trivially copyable.
+ */
+class RID {
+ public:
+  RID() = default;
+
+  RID(page_id_t page_id, int slot) : page_id_(page_id), slot_(slot) {}
+
+  inline page_id_t GetPageId() const { return page_id_; }
+
+  inline int GetSlot() const { return slot_; }
+
+  bool operator==(const RID &other) const { return page_id_ == other.page_id_ && slot_ == other.slot_; }
+
+ private:
+  page_id_t page_id_{INVALID_PAGE_ID};
+  int slot_{-1};
+};
+
+}  // namespace thomas
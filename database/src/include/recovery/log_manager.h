@@ -0,0 +1,219 @@
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>   // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+
+#include "common/config.h"
+#include "container/vector.hpp"
+
+namespace thomas {
+
+/**
+ * LogManager keeps a write-ahead log for the files of the indexes, so that they survive a crash at any point with the
+ * state of the last commit.
+ *
+ * A buffer pool logs a page before writing it back, as the byte ranges changed since the page was last logged, each
+ * with its old and new bytes. The log is forced up to the record before the page is written, and at a commit every
+ * changed page is logged, so the log always has enough to redo the pages written and to undo what isn't committed.
+ * The LSN of a record is its offset in the log file.
+ *
+ * Format of a log record (size in byte):
+ *  ---------------------------------------------------------------------------
+ * | Size (4) | Checksum (4) | Type (4) | FileId (4) | PageId (4) | Payload ... |
+ *  ---------------------------------------------------------------------------
+ * Payload of an UPDATE record:
+ *  -------------------------------------------------------------------------------------------------
+ * | RangeCount (4) | Offset_1 (4) | Length_1 (4) | OldBytes_1 (Length_1) | NewBytes_1 (Length_1) | ... |
+ *  -------------------------------------------------------------------------------------------------
+ * A REDO record is an UPDATE without the old bytes, logged at a commit. A page is written back only after the commit
+ * following its records is on disk, so that such a record is never undone. A file without page images, like an undo
+ * stack, logs the bytes it appends as REDO records too. The payload of a FILE record is the file name, TRUNCATE and
+ * COMMIT records have none.
+ *
+ * The commits are grouped: a commit appends its record and returns, and a background thread writes and syncs the
+ * buffer every LOG_TIMEOUT ms, or earlier when it's asked to. On startup the log is replayed, every page written is
+ * redone and the records after the last commit are undone. Once the log grows past LOG_CHECKPOINT_SIZE, all the
+ * pages are written back and the log starts over.
+ */
+class LogManager {
+ public:
+  enum class LogRecordType { INVALID = 0, UPDATE, REDO, FILE, TRUNCATE, COMMIT };
+
+  /**
+   * Called with false at a commit to log the changed pages of a file, and with true at a checkpoint to write back
+   * all of them and sync the file.
+   */
+  using Participant = std::function<void(bool checkpoint)>;
+
+  /**
+   * @brief
+   * Open the log, recover the files from it if the last run didn't end cleanly, and start the flush thread. It must
+   * be constructed before any index logging to it.
+   * @param log_file the name of the log file
+   */
+  explicit LogManager(const std::string &log_file);
+
+  ~LogManager();
+
+  /**
+   * @brief
+   * Register a file whose pages are logged.
+   * @param file_name the name of the file
+   * @param participant called at the commits and the checkpoints
+   * @return the id of the file in the log records
+   */
+  int RegisterFile(const std::string &file_name, const Participant &participant);
+
+  /**
+   * @brief
+   * Unregister a file once all of its pages are written back, the log is emptied when the last one is gone.
+   */
+  void UnregisterFile(int file_id);
+
+  /**
+   * @brief
+   * Log the changes of a page since its last record, and bring the old image up to date.
+   * @param logged_image the page as of its last record, updated in place
+   * @param page_data the page now
+   * @param is_undoable whether the old bytes are logged, they are needed unless it's logged at a commit
+   * @return the LSN of the record, INVALID_LSN if nothing changed
+   */
+  lsn_t AppendUpdate(int file_id, page_id_t page_id, char *logged_image, const char *page_data,
+                     bool is_undoable = true);
+
+  /**
+   * @brief
+   * Log the new bytes of a range in a page, for a file that keeps no image of its pages. The range is redone only if
+   * a commit follows it.
+   * @param offset the offset of the range in the page
+   * @return the LSN of the record
+   */
+  lsn_t AppendRedo(int file_id, page_id_t page_id, int offset, const char *data, int length);
+
+  /**
+   * @brief
+   * Log the truncation of a file, before it's truncated. The work before it is committed, and the truncation is
+   * committed on its own, because it can't be undone.
+   */
+  void Truncate(int file_id);
+
+  /**
+   * @brief
+   * Commit the changes made so far, the participants log their changed pages first.
+   * @param force wait until the commit is on disk, otherwise it's synced with the group within LOG_TIMEOUT ms
+   */
+  void Commit(bool force = false);
+
+  /**
+   * @brief
+   * Checkpoint once the log grows past LOG_CHECKPOINT_SIZE. It's left out of Commit(), so that the caller can answer
+   * for a commit before all the pages are written back.
+   */
+  void CheckpointIfLong();
+
+  /**
+   * @brief
+   * Block until a page whose last record is at the LSN can be written back: the log is on disk up to the record, and
+   * up to the commit after it if it's logged at a commit.
+   */
+  void Flush(lsn_t lsn);
+
+  /** @return whether a page whose last record is at the LSN can be written back without waiting */
+  bool IsDurable(lsn_t lsn);
+
+  /**
+   * @brief
+   * Commit, write back all the pages, then empty the log. Called when the log grows too long, and around the offline
+   * work that rewrites the files without logging, like the compaction.
+   */
+  void Checkpoint();
+
+ private:
+  struct LogFile {
+    std::string name_;
+    Participant participant_;
+    bool is_registered_;
+  };
+
+  static constexpr int LOG_RECORD_HEADER_SIZE = 20;
+
+  /** @brief redo the whole log and undo the records after the last commit, then empty the log */
+  void Recover();
+
+  /** @brief let the participants log their changed pages, then append a COMMIT record */
+  lsn_t LogCommit();
+
+  /** @brief append a record without payload, or with a raw payload, the latch should be held */
+  lsn_t AppendRecord(std::unique_lock<std::mutex> *lock, LogRecordType type, int file_id, page_id_t page_id,
+                     const char *payload = nullptr, int payload_size = 0);
+
+  /** @brief wait until the buffer has room for the record, the latch should be held */
+  char *Reserve(std::unique_lock<std::mutex> *lock, int size);
+
+  /** @brief seal the record reserved at the end of the buffer with its header and checksum */
+  lsn_t Seal(char *record, int size, LogRecordType type, int file_id, page_id_t page_id);
+
+  /** @brief wait until the log is on disk up to the record, the latch should be held */
+  void WaitDurable(std::unique_lock<std::mutex> *lock, lsn_t lsn);
+
+  /** @brief rethrow the error of the flush thread if it's stopped by one, the latch should be held */
+  void CheckFlushError();
+
+  /**
+   * @return whether the record is logged by the commit going on, the latch should be held. The committer itself only
+   * writes back the victims evicted by the participants, which are logged before their REDO records.
+   */
+  bool IsCommitting(lsn_t lsn) {
+    return is_committing_ && lsn >= commit_begin_lsn_ && committer_ != std::this_thread::get_id();
+  }
+
+  /** @brief log the FILE records of the registered files at the start of the log, the latch should be held */
+  void LogFiles(std::unique_lock<std::mutex> *lock);
+
+  /** @brief empty the log file, the latch should be held and nothing should be in flight */
+  void TruncateLog();
+
+  void FlushFunction();
+
+  static uint32_t Checksum(const char *data, int size);
+
+  std::string log_name_;
+  int log_fd_;
+
+  /** The records are appended to the log buffer, and written from the flush buffer by the flush thread. */
+  char *log_buffer_;
+  char *flush_buffer_;
+  int log_buffer_size_{0};
+  /** The LSN of the next record, and the one before which all the records are on disk. */
+  lsn_t next_lsn_{0};
+  lsn_t persistent_lsn_{0};
+  /** The size of the log file, only changed by the flush thread and the truncation. */
+  lsn_t file_size_{0};
+  /** The last COMMIT record, and the first record of the commit going on. */
+  lsn_t last_commit_lsn_{INVALID_LSN};
+  lsn_t commit_begin_lsn_{0};
+  bool is_committing_{false};
+  std::thread::id committer_;
+
+  vector<LogFile> files_;
+  int registered_num_{0};
+
+  /** Protects all of the above. */
+  std::mutex latch_;
+  std::thread flush_thread_;
+  bool flush_requested_{false};
+  bool is_terminated_{false};
+  /** The error that stopped the flush thread, if any. */
+  std::exception_ptr flush_error_;
+  /** Wakes up the flush thread. */
+  std::condition_variable flush_cv_;
+  /** Notified when the buffers are swapped, when the log is synced and when a commit is logged. */
+  std::condition_variable flushed_cv_;
+};
+
+}  // namespace thomas
@@ -1,22 +1,45 @@
 #pragma once
 
 #include <atomic>
-#include <fstream>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <string>
+#include <thread>
+
+#ifdef THOMAS_HAVE_LIBURING
+#include <liburing.h>
+#endif
 
 #include "common/config.h"
 
 namespace thomas {
 
+/**
+ * @brief
+ * An asynchronous page request. It's owned by the caller and must stay alive until it's completed.
+ */
+struct DiskRequest {
+  bool is_write_{false};
+  page_id_t page_id_{INVALID_PAGE_ID};
+  char *data_{nullptr};
+  /* set by the disk manager */
+  bool done_{false};
+  /* 0 for success, 1 for reading less than a page, -1 for I/O error */
+  int error_{0};
+};
+
 class DiskManager {
  public:
   /**
    * creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param direct_io bypass the page cache with O_DIRECT, the page buffers should be aligned to DIRECT_IO_ALIGNMENT,
+   * falls back to buffered I/O when the file system does not support it
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, bool direct_io = false);
 
-  ~DiskManager() = default;
+  ~DiskManager();
 
   /**
    * @brief
@@ -31,8 +54,13 @@ class DiskManager {
   void Clear();
 
   /**
-move sibling page's last key & value pair into head of input
- * "node".
+   * @brief
+   * Force the written pages to the disk, called by the index at checkpoints.
+   */
+  void Sync();
+
+  /**
+   * @brief
    * Write a page to the database file.
    * @param page_id id of the page
    * @param page_data raw page data
@@ -49,28 +77,95 @@ move sibling page's last key & value pair into head of input
 
   /**
    * @brief
-   * Allocate a page on disk.
+   * Submit an asynchronous read or write, served by io_uring when it's available and by an I/O thread otherwise.
+   * @param request the request, whose data buffer must not be touched until it's completed
+   */
+  void Submit(DiskRequest *request);
+
+  /**
+   * @brief
+   * Whether asynchronous requests pay off. With O_DIRECT or io_uring the device does the work in the background, but
+   * a buffered write handed over to the I/O thread costs more than the memcpy into the page cache it replaces.
+   */
+  bool IsAsyncPreferred();
+
+  /**
+   * @brief
+   * Check whether a submitted request is completed, without blocking.
+   * @param request the submitted request
+   * @return true if it's completed
+   */
+  bool Poll(DiskRequest *request);
+
+  /**
+   * @brief
+   * Block until a submitted request is completed, and throw the same exceptions as ReadPage and WritePage.
+   * @param request the submitted request
+   */
+  void Wait(DiskRequest *request);
+
+  /**
+   * @brief
+   * Allocate a page on disk, a freed page is reused first.
    * @return the id of the allocated page
    */
   page_id_t AllocatePage();
 
   /**
    * @brief
-   * Deallocate a page on disk.
+   * Deallocate a page on disk. The freed pages are chained through their first bytes, so the list costs no memory and
+   * only its head is kept, persisted by the index in its header page.
    * @param page_id id of the page to deallocate
    */
   void DeallocatePage(page_id_t page_id);
 
+  /**
+   * @brief
+   * Fill in what DeallocatePage would write into the page, so that the write can be logged before it's done.
+   * @param page_id id of the page to deallocate
+   * @param[out] page_data the freed page, linked to the current head of the freed pages
+   * @return false if the page is never freed
+   */
+  bool GetFreedPage(page_id_t page_id, char *page_data);
+
+  const std::string &GetFileName() { return file_name_; }
+
   void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
 
   page_id_t GetNextPageId() { return next_page_id_; }
 
+  void SetFreePageId(page_id_t free_page_id) { free_page_id_ = free_page_id; }
+
+  /** @return the head of the freed pages, INVALID_PAGE_ID for none */
+  page_id_t GetFreePageId() { return free_page_id_; }
+
  private:
-  int GetFileSize(const std::string &file_name);
-  // stream to write db file
-  std::fstream db_io_;
+  void Open();
+  void Serve(DiskRequest *request);
+  void WorkerFunction();
+  void StopWorker();
+  // file descriptor of db file
+  int db_fd_;
+  bool direct_io_;
   std::string file_name_;
   std::atomic<page_id_t> next_page_id_;
+  std::atomic<page_id_t> free_page_id_;
+  /* guards the list of freed pages, the plain allocation only bumps the counter */
+  std::mutex free_latch_;
+
+  /* the asynchronous part, started on the first submission */
+#ifdef THOMAS_HAVE_LIBURING
+  void Reap(bool block);
+  struct io_uring ring_;
+  bool ring_ready_{false};
+#endif
+  bool async_started_{false};
+  std::thread worker_;
+  std::deque<DiskRequest *> requests_;
+  std::mutex io_latch_;
+  std::condition_variable request_cv_;
+  std::condition_variable done_cv_;
+  bool is_terminated_{false};
 };
 
 }  // namespace thomas
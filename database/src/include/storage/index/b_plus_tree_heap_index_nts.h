@@ -0,0 +1,74 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "common/rid.h"
+#include "container/vector.hpp"
+#include "storage/index/b_plus_tree_index_nts.h"
+#include "storage/table/table_heap.h"
+
+namespace thomas {
+
+/**
+ * BPlusTreeHeapIndexNTS is a non-thread-safe index for large values. The values are kept out of line in a table heap,
+ * and the leaves of the b+ tree only map the keys to their RIDs, so that a leaf holds far more keys and the tree stays
+ * shallow. It has the same interface as BPlusTreeIndexNTS.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTreeHeapIndexNTS {
+ public:
+  using Visitor = std::function<bool(const KeyType &, const ValueType &)>;
+  using KeyVisitor = std::function<bool(const KeyType &)>;
+  using Modifier = std::function<void(const KeyType &, ValueType *)>;
+
+  explicit BPlusTreeHeapIndexNTS(const std::string &index_name, const KeyComparator &key_comparator,
+                                 int buffer_pool_size = BUFFER_POOL_SIZE, bool enable_cleaner = false,
+                                 REPLACER_TYPE replacer_type = REPLACER_TYPE::LRU, bool enable_swizzling = false,
+                                 LogManager *log_manager = nullptr);
+  ~BPlusTreeHeapIndexNTS();
+
+  bool IsEmpty();
+
+  void InsertEntry(const KeyType &key, const ValueType &value);
+
+  void DeleteEntry(const KeyType &key);
+
+  void ScanKey(const KeyType &key, vector<ValueType> *result, const KeyComparator &standby_comparator);
+
+  void SearchKey(const KeyType &key, vector<ValueType> *result);
+
+  /* the keys are sorted, and their records are read, changed and written back in place */
+  int ModifyEntries(const vector<KeyType> &keys, const Modifier &modifier);
+
+  int Scan(const KeyType &lower, const KeyType &upper, const Visitor &visitor);
+
+  /* the keys alone are in the tree, so counting or locating a key by its rank reads no record */
+  int ScanKeys(const KeyType &lower, const KeyType &upper, const KeyVisitor &visitor);
+
+  /* the same as above, from the greatest key down */
+  int ReverseScan(const KeyType &lower, const KeyType &upper, const Visitor &visitor);
+
+  int ReverseScanKeys(const KeyType &lower, const KeyType &upper, const KeyVisitor &visitor);
+
+  int Size();
+
+  void Clear();
+
+  void Flush();
+
+  /* only the tree is compacted, the heap reuses its free space by itself */
+  void Compact();
+
+  void Debug();
+
+ private:
+  void FetchValues(const vector<RID> &rids, vector<ValueType> *result);
+
+  BPlusTreeIndexNTS<KeyType, RID, KeyComparator> *index_;
+  TableHeap *heap_;
+};
+
+}  // namespace thomas
@@ -3,9 +3,11 @@
 #include <mutex>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "common/config.h"
 #include "concurrency/transaction.h"
 #include "container/vector.hpp"
+#include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/index/b_plus_tree_nts.h"
 #include "storage/page/header_page.h"
@@ -16,32 +18,55 @@ INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeIndexNTS {
  public:
   explicit BPlusTreeIndexNTS(const std::string &index_name, const KeyComparator &key_comparator,
-                             int buffer_pool_size = BUFFER_POOL_SIZE);
+                             int buffer_pool_size = BUFFER_POOL_SIZE, bool enable_cleaner = false,
+                             REPLACER_TYPE replacer_type = REPLACER_TYPE::LRU, bool enable_swizzling = false,
+                             LogManager *log_manager = nullptr);
   ~BPlusTreeIndexNTS();
 
   bool IsEmpty();
 
   void InsertEntry(const KeyType &key, const ValueType &value);
 
+  void BulkLoad(const MappingType *begin, const MappingType *end, double fill_factor = 1.0);
+
   void DeleteEntry(const KeyType &key);
 
   void ScanKey(const KeyType &key, vector<ValueType> *result, const KeyComparator &standby_comparator);
 
   void SearchKey(const KeyType &key, vector<ValueType> *result);
 
+  int Scan(const KeyType &lower, const KeyType &upper, const typename BPLUSTREENTS_TYPE::Visitor &visitor);
+
+  int ReverseScan(const KeyType &lower, const KeyType &upper, const typename BPLUSTREENTS_TYPE::Visitor &visitor);
+
+  int MultiGet(const vector<KeyType> &keys, vector<ValueType> *result, vector<bool> *found = nullptr);
+
   int Size();
 
   void Clear();
 
+  void Flush();
+
+  void Compact();
+
   void Debug();
 
  private:
+  /* the metadata is written into the header page, which is marked dirty only when it changes */
+  void SyncHeader();
+
+  /* the participant of the log manager */
+  void Persist(bool checkpoint);
+
   char index_name_[32];
   DiskManager *disk_manager_;
   BufferPoolManager *bpm_;
   HeaderPage *header_page_;
   int buffer_pool_size_;
+  bool enable_swizzling_;
   int size_;
+  LogManager *log_manager_;
+  int file_id_{-1};
 
   KeyComparator key_comparator_;
 
@@ -3,6 +3,8 @@
 #include <mutex>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
 #include "concurrency/transaction.h"
 #include "container/vector.hpp"
 #include "storage/disk/disk_manager.h"
@@ -16,7 +18,8 @@ INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeIndexTS {
  public:
   explicit BPlusTreeIndexTS(const std::string &index_name, const KeyComparator &key_comparator, ThreadPool *pool,
-                            int buffer_pool_size = 10000);
+                            int buffer_pool_size = 10000, bool enable_cleaner = false, int num_instances = 1,
+                            REPLACER_TYPE replacer_type = REPLACER_TYPE::LRU);
   ~BPlusTreeIndexTS();
 
   void InsertEntry(const KeyType &key, const ValueType &value);
@@ -27,6 +30,8 @@ class BPlusTreeIndexTS {
 
   void SearchKey(const KeyType &key, vector<ValueType> *result);
 
+  void Flush();
+
   void Debug();
 
   void ResetPool(ThreadPool *pool);
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <functional>
+
 #include "concurrency/transaction.h"
+#include "storage/disk/disk_manager.h"
 #include "storage/index/index_iterator.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
@@ -17,15 +20,30 @@ class BPlusTreeNTS {
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
 
  public:
+  // Called on each pair of a scan, returns false to stop the scan.
+  using Visitor = std::function<bool(const KeyType &, const ValueType &)>;
+
   explicit BPlusTreeNTS(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
                         int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
 
+  // Releases the swizzled pages, so it should be destroyed before the buffer pool.
+  ~BPlusTreeNTS();
+
+  // Keep up to SWIZZLE_CAPACITY inner pages pinned, with direct pointers to their swizzled children, so that the
+  // descents through them skip the buffer pool.
+  void SetSwizzling(bool enable_swizzling);
+
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
 
   // Insert a key-value pair into this B+ tree.
   bool Insert(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
 
+  // Insert key-value pairs sorted by unique keys. An empty tree is built bottom-up, with the pages filled to
+  // fill_factor. Otherwise the pairs falling into one leaf share one descent, and those after the end of a leaf fill
+  // new leaves instead of splitting it. Returns the number of new keys.
+  int BulkLoad(const MappingType *begin, const MappingType *end, double fill_factor = 1.0);
+
   // Remove a key and its value from this B+ tree.
   bool Remove(const KeyType &key, Transaction *transaction = nullptr);
 
@@ -35,10 +53,28 @@ class BPlusTreeNTS {
   bool GetValue(const KeyType &key, vector<ValueType> *result, const KeyComparator &new_comparator,
                 Transaction *transaction = nullptr);
 
+  // Visit the pairs with lower <= key <= upper in order, the values are read in place from the pinned leaves, so the
+  // visitor must not change the tree. Returns the number of pairs visited.
+  int Scan(const KeyType &lower, const KeyType &upper, const Visitor &visitor);
+
+  // Visit the pairs with lower <= key <= upper from the greatest key down, following the prev links of the leaves, so
+  // the last few keys of a range are reached without walking all the others. Returns the number of pairs visited.
+  int ReverseScan(const KeyType &lower, const KeyType &upper, const Visitor &visitor);
+
+  // Look up keys sorted in order with one descent, the following keys are found in the same leaf or the next one
+  // before descending again. Returns the number of keys found.
+  int GetValues(const KeyType *keys, int size, ValueType *values, bool *found);
+
+  // Write the tree into another file densely, renumbering the pages from 1 in breadth-first order. Returns the number of
+  // pages used, the header page included.
+  page_id_t CompactTo(DiskManager *disk_manager);
+
   // index iterator
   INDEXITERATOR_TYPE begin();  // NOLINT
   INDEXITERATOR_TYPE Begin(const KeyType &key);
   INDEXITERATOR_TYPE end();  // NOLINT
+  // Start at the last key not greater than the given one, and walk backward with operator--.
+  INDEXITERATOR_TYPE RBegin(const KeyType &key);
 
   void Print(BufferPoolManager *bpm) {
     ToString(reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(root_page_id_)->GetData()), bpm);
@@ -48,6 +84,24 @@ class BPlusTreeNTS {
   Page *FindLeafPage(const KeyType &key, bool leftMost = false, bool rightMost = false);
 
  private:
+  /* an inner page pinned in the buffer pool, with its swizzled children by their index */
+  struct SwizzleNode {
+    Page *page_;
+    SwizzleNode **children_;
+  };
+
+  // Descend from a pinned page through the buffer pool.
+  Page *FindLeafPageFrom(Page *page, const KeyType &key, bool leftMost, bool rightMost);
+
+  Page *FindLeafPageSwizzled(const KeyType &key, bool leftMost, bool rightMost);
+
+  SwizzleNode *NewSwizzleNode(Page *page);
+
+  void DeleteSwizzleNode(SwizzleNode *node);
+
+  // Unpin all the swizzled pages, called before the structure of the tree changes.
+  void Unswizzle();
+
   template <typename N>
   N *NewNode(page_id_t parent_id, IndexPageType page_type);
 
@@ -61,6 +115,18 @@ class BPlusTreeNTS {
   template <typename N>
   N *Split(N *node);
 
+  // Keep the leaves doubly linked, a split or a bulk load links a new leaf after another one.
+  void LinkAfter(LeafPage *leaf_node, LeafPage *extra_node);
+
+  void SetPrevOf(page_id_t page_id, page_id_t prev_page_id);
+
+  int LastIndexNotAfter(LeafPage *leaf_node, const KeyType &key);
+
+  void BuildBottomUp(const MappingType *begin, const MappingType *end, double fill_factor);
+
+  // Find the smallest separator above a node, which every key of the node is less than.
+  bool UpperBoundOf(BPlusTreePage *node, KeyType *bound);
+
   template <typename N>
   bool CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr);
 
@@ -87,6 +153,9 @@ class BPlusTreeNTS {
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
+  bool enable_swizzling_{false};
+  SwizzleNode *swizzle_root_{nullptr};
+  int swizzled_num_{0};
 };
 
 }  // namespace thomas
@@ -94,6 +94,8 @@ class BPlusTreeTS {
   template <typename N>
   N *Split(N *node);
 
+  void SetPrevOf(page_id_t page_id, page_id_t prev_page_id);
+
   template <typename N>
   bool CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr);
 
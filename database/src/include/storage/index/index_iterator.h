@@ -20,10 +20,13 @@ class IndexIterator {
 
   bool isEnd();
 
-  const MappingType &operator*();
+  MappingType operator*();
 
   IndexIterator &operator++();
 
+  // Step back, across the prev link at the first key of a leaf, and become the end before the first key of the tree.
+  IndexIterator &operator--();
+
   bool operator==(const IndexIterator &itr) const { return ptr_ == itr.ptr_ && index_ == itr.index_; }
 
   bool operator!=(const IndexIterator &itr) const { return ptr_ != itr.ptr_ || index_ != itr.index_; }
@@ -32,13 +32,16 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   void SetKeyAt(int index, const KeyType &key);
   int ValueIndex(const ValueType &value) const;
   ValueType ValueAt(int index) const;
+  void SetValueAt(int index, const ValueType &value);
 
+  int LookupIndex(const KeyType &key, const KeyComparator &comparator) const;
   ValueType Lookup(const KeyType &key, const KeyComparator &comparator) const;
   void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
   int InsertNodeAfter(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
   void Remove(int index);
   int Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator);
   ValueType RemoveAndReturnOnlyChild();
+  void Append(const KeyType &key, const ValueType &value);
 
   // Split and Merge utility methods
   void MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key, BufferPoolManager *buffer_pool_manager);
@@ -7,26 +7,30 @@
 namespace thomas {
 
 #define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
-#define LEAF_PAGE_HEADER_SIZE 28
-#define LEAF_PAGE_SIZE ((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
+#define LEAF_PAGE_HEADER_SIZE 32
+/* the two arrays are aligned apart, which costs at most 16 bytes */
+#define LEAF_PAGE_SIZE ((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE - 16) / (sizeof(KeyType) + sizeof(ValueType)))
 
 /**
  * Store indexed key and record id(record id = page id combined with slot id,
  * see include/common/rid.h for detailed implementation) together within leaf
  * page. Only support unique key.
  *
+ * The keys and the values are kept in two arrays, so that a search only walks the keys, which are dense in the
+ * cache however large the values are. The values start right after room for MaxSize keys.
+ *
  * Leaf page format (keys are stored in order):
- *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
- *  ----------------------------------------------------------------------
+ *  ----------------------------------------------------------------------------------------
+ * | HEADER | KEY(1) | KEY(2) | ... | KEY(n) | ... | VALUE(1) | VALUE(2) | ... | VALUE(n) | ...
+ *  ----------------------------------------------------------------------------------------
  *
- *  Header format (size in byte, 28 bytes in total):
+ *  Header format (size in byte, 32 bytes in total):
  *  ---------------------------------------------------------------------
  * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  *  ---------------------------------------------------------------------
- *  -----------------------------------------------
- * | ParentPageId (4) | PageId (4) | NextPageId (4)
- *  -----------------------------------------------
+ *  ----------------------------------------------------------------
+ * | ParentPageId (4) | PageId (4) | NextPageId (4) | PrevPageId (4) |
+ *  ----------------------------------------------------------------
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeLeafPage : public BPlusTreePage {
@@ -37,12 +41,16 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   // helper methods
   page_id_t GetNextPageId() const;
   void SetNextPageId(page_id_t next_page_id);
+  page_id_t GetPrevPageId() const;
+  void SetPrevPageId(page_id_t prev_page_id);
   KeyType KeyAt(int index) const;
+  const ValueType &ValueAt(int index) const;
   int KeyIndex(const KeyType &key, const KeyComparator &comparator) const;
-  const MappingType &GetItem(int index);
+  MappingType GetItem(int index);
 
   // insert and delete methods
   int Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator);
+  void Append(const MappingType *items, int size);
   bool Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const;
   int RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator);
   void Remove(int index);
@@ -54,11 +62,20 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   void MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
 
  private:
-  void CopyNFrom(MappingType *items, int size);
-  void CopyLastFrom(const MappingType &item);
-  void CopyFirstFrom(const MappingType &item);
+  KeyType *KeyArray() { return reinterpret_cast<KeyType *>(data_); }
+  const KeyType *KeyArray() const { return reinterpret_cast<const KeyType *>(data_); }
+  ValueType *ValueArray() { return reinterpret_cast<ValueType *>(data_ + ValueOffset()); }
+  const ValueType *ValueArray() const { return reinterpret_cast<const ValueType *>(data_ + ValueOffset()); }
+  size_t ValueOffset() const {
+    return (GetMaxSize() * sizeof(KeyType) + alignof(ValueType) - 1) / alignof(ValueType) * alignof(ValueType);
+  }
+
+  void CopyNFrom(const KeyType *keys, const ValueType *values, int size);
+  void CopyLastFrom(const KeyType &key, const ValueType &value);
+  void CopyFirstFrom(const KeyType &key, const ValueType &value);
   page_id_t next_page_id_;
-  MappingType array[0];
+  page_id_t prev_page_id_;
+  alignas(MappingType) char data_[0];
 };
 
 }  // namespace thomas
@@ -16,7 +16,7 @@ namespace thomas {
  */
 class Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
-  friend class BufferPoolManager;
+  friend class BufferPoolManagerInstance;
 
  public:
   /** Constructor. Zeros out the page data. */
@@ -67,8 +67,8 @@ class Page {
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
-  /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  /** The actual data that is stored within a page, aligned so that it can be used for O_DIRECT. */
+  alignas(DIRECT_IO_ALIGNMENT) char data_[PAGE_SIZE]{};
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
   /** The pin count of this page. */
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstring>
+
+#include "storage/page/page.h"
+
+namespace thomas {
+
+/**
+ * TablePage is a slotted page of a table heap. The slot array grows from the header, and the records grow from the
+ * end of the page towards it. A deleted record leaves an empty slot to be reused, and the records after it are moved
+ * up, so the free space is always the gap in the middle.
+ *
+ * Format (size in byte):
+ *  ----------------------------------------------------------------------------------------------------
+ * | FreeSpacePointer (4) | SlotCount (4) | FsmIndex (4) | Slot_1 offset (4) | Slot_1 size (4) | ... |
+ *  ----------------------------------------------------------------------------------------------------
+ *  -------------------------------------------------
+ * | ... free space ... | Record_n | ... | Record_1 |
+ *  -------------------------------------------------
+ */
+class TablePage : public Page {
+ public:
+  static constexpr int TABLE_PAGE_HEADER_SIZE = 12;
+  static constexpr int SLOT_SIZE = 8;
+
+  /**
+   * @brief
+   * Initialize an empty table page.
+   * @param fsm_index the index of the page in the free space map of its table heap
+   */
+  void Init(int fsm_index);
+
+  /** @return the bytes between the slot array and the records */
+  int GetFreeSpace();
+
+  /** @return the bytes a record of the size would take, including a new slot if no slot can be reused */
+  int GetSpaceNeeded(int size);
+
+  int GetFsmIndex();
+
+  int GetSlotCount();
+
+  /**
+   * @brief
+   * Insert a record, reusing an empty slot if any.
+   * @param[out] slot the slot of the record
+   * @return false if there is no room for it
+   */
+  bool InsertRecord(const char *data, int size, int *slot);
+
+  /** @return the record in the slot, nullptr if it's empty */
+  const char *GetRecord(int slot);
+
+  /** @return the size of the record in the slot, 0 if it's empty */
+  int GetRecordSize(int slot);
+
+  /**
+   * @brief
+   * Overwrite a record in place, its size can't change.
+   */
+  bool UpdateRecord(int slot, const char *data, int size);
+
+  /**
+   * @brief
+   * Delete a record and compact the records after it.
+   */
+  bool DeleteRecord(int slot);
+
+ private:
+  int GetFreeSpacePointer();
+  void SetFreeSpacePointer(int free_space_pointer);
+  void SetSlotCount(int slot_count);
+  int GetSlotOffset(int slot);
+  int GetSlotSize(int slot);
+  void SetSlot(int slot, int offset, int size);
+  /** @return the first empty slot, -1 for none */
+  int FindEmptySlot();
+};
+}  // namespace thomas
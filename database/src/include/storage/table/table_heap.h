@@ -0,0 +1,97 @@
+#pragma once
+
+#include <string>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "common/rid.h"
+#include "container/vector.hpp"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/header_page.h"
+#include "storage/page/table_page.h"
+
+namespace thomas {
+
+/**
+ * TableHeap stores records of any size out of the index, in slotted table pages of its own file, and hands back a RID
+ * for each. The free space of every table page is kept in a free space map, so that an insert picks a page with room
+ * without fetching the pages one by one.
+ *
+ * The free space map is persisted in a chain of pages, whose first page id is in the header page.
+ * Format of a free space map page (size in byte):
+ *  ------------------------------------------------------------------------------------------
+ * | NextPageId (4) | EntryCount (4) | Entry_1 page_id (4) | Entry_1 free_space (4) | ... |
+ *  ------------------------------------------------------------------------------------------
+ */
+class TableHeap {
+ public:
+  explicit TableHeap(const std::string &file_name, int buffer_pool_size = BUFFER_POOL_SIZE,
+                     REPLACER_TYPE replacer_type = REPLACER_TYPE::LRU, LogManager *log_manager = nullptr);
+  ~TableHeap();
+
+  /**
+   * @brief
+   * Insert a record, a record can't be larger than a table page.
+   * @return the RID of the record
+   */
+  RID InsertRecord(const char *data, int size);
+
+  /**
+   * @brief
+   * Copy a record out.
+   * @return false if there is no such record
+   */
+  bool GetRecord(const RID &rid, char *data);
+
+  /**
+   * @brief
+   * Overwrite a record in place, its size can't change.
+   */
+  bool UpdateRecord(const RID &rid, const char *data, int size);
+
+  bool DeleteRecord(const RID &rid);
+
+  void Clear();
+
+  void Flush();
+
+  /** @return the number of pages in the file */
+  int GetPageNum();
+
+ private:
+  struct FreeSpaceEntry {
+    page_id_t page_id_;
+    int free_space_;
+  };
+
+  static constexpr int FSM_PAGE_HEADER_SIZE = 8;
+  static constexpr int FSM_PAGE_SIZE = (PAGE_SIZE - FSM_PAGE_HEADER_SIZE) / sizeof(FreeSpaceEntry);
+
+  /** @return the new table page, pinned */
+  TablePage *NewTablePage();
+  void LoadFreeSpaceMap();
+  void StoreFreeSpaceMap();
+  /* the free space map and the metadata are written into their pages, only when they change */
+  void SyncHeader();
+  /* the participant of the log manager */
+  void Persist(bool checkpoint);
+
+  DiskManager *disk_manager_;
+  BufferPoolManager *bpm_;
+  HeaderPage *header_page_;
+
+  vector<FreeSpaceEntry> free_space_map_;
+  /* the map indexes of the pages that got room back from deletes, they may be stale */
+  vector<int> candidates_;
+  /* the map index of the page taking the inserts, -1 for none */
+  int current_{-1};
+  /* whether the map is changed since it's stored */
+  bool is_map_changed_{false};
+
+  LogManager *log_manager_;
+  int file_id_{-1};
+};
+
+}  // namespace thomas
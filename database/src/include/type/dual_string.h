@@ -4,6 +4,7 @@
 #include <cstring>
 #include <iostream>
 
+#include "type/normalized_key.h"
 #include "type/string.h"
 
 namespace thomas {
@@ -44,6 +45,12 @@ class DualString {
 
   int CompareSecondWith(const DualString &rhs) const { return second_str_.CompareWith(rhs.second_str_); }
 
+  /* both strings are adjacent and normalized, so they are compared in one pass */
+  int CompareBothWith(const DualString &rhs) const {
+    return CompareKeyBytes(reinterpret_cast<const char *>(this), reinterpret_cast<const char *>(&rhs),
+                           FirstStringSize + SecondStringSize);
+  }
+
   friend std::ostream &operator<<(std::ostream &os, const DualString &src) {
     os << "(" << src.first_str_ << "," << src.second_str_ << ")";
     return os;
@@ -52,6 +59,8 @@ class DualString {
  private:
   String<FirstStringSize> first_str_;
   String<SecondStringSize> second_str_;
+
+  static_assert(sizeof(String<FirstStringSize>) == FirstStringSize, "the strings must be adjacent");
 };
 
 /**
@@ -72,15 +81,11 @@ class DualStringComparator {
 
   int operator()(const DualString<FirstStringSize, SecondStringSize> &lhs,
                  const DualString<FirstStringSize, SecondStringSize> &rhs) const {
-    auto first_result = lhs.CompareFirstWith(rhs);
     switch (type_) {
       case 1:
-        return first_result;
+        return lhs.CompareFirstWith(rhs);
       case 2:
-        if (first_result != 0) {
-          return first_result;
-        }
-        return lhs.CompareSecondWith(rhs);
+        return lhs.CompareBothWith(rhs);
       default:
         return 0;
     }
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace thomas {
+
+/*
+ * The keys are kept normalized: a string is zero-padded to its full width, and an int is stored big-endian with its
+ * sign bit flipped. Then the bytes of a key, or of any leading fields of it, are ordered exactly like the key, and a
+ * comparison is one pass over a fixed number of bytes, without looking for terminators or branching per field.
+ */
+
+/** @return the order-preserving big-endian form of an int */
+inline uint32_t EncodeKeyInt(int value) { return __builtin_bswap32(static_cast<uint32_t>(value) ^ 0x80000000U); }
+
+inline int DecodeKeyInt(uint32_t encoded) { return static_cast<int>(__builtin_bswap32(encoded) ^ 0x80000000U); }
+
+/**
+ * @brief
+ * compare two normalized keys as unsigned bytes, 16 bytes a step with SSE2 and then 8 bytes a step, the size is known
+ * at compile time in all the callers, so the loops are unrolled
+ * @return negative, zero or positive like memcmp
+ */
+inline int CompareKeyBytes(const char *lhs, const char *rhs, size_t size) {
+  size_t i = 0;
+#ifdef __SSE2__
+  for (; i + 16 <= size; i += 16) {
+    __m128i lhs_block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lhs + i));
+    __m128i rhs_block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rhs + i));
+    unsigned diff = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(lhs_block, rhs_block))) ^ 0xFFFFU;
+    if (diff != 0) {
+      i += __builtin_ctz(diff);
+      return static_cast<int>(static_cast<unsigned char>(lhs[i])) - static_cast<unsigned char>(rhs[i]);
+    }
+  }
+#endif
+  for (; i + 8 <= size; i += 8) {
+    uint64_t lhs_word;
+    uint64_t rhs_word;
+    memcpy(&lhs_word, lhs + i, 8);
+    memcpy(&rhs_word, rhs + i, 8);
+    if (lhs_word != rhs_word) {
+      /* little-endian loads, so the first byte has to become the most significant one */
+      return __builtin_bswap64(lhs_word) < __builtin_bswap64(rhs_word) ? -1 : 1;
+    }
+  }
+  for (; i < size; ++i) {
+    if (lhs[i] != rhs[i]) {
+      return static_cast<int>(static_cast<unsigned char>(lhs[i])) - static_cast<unsigned char>(rhs[i]);
+    }
+  }
+  return 0;
+}
+
+}  // namespace thomas
@@ -4,8 +4,15 @@
 #include <cstring>
 #include <iostream>
 
+#include "type/normalized_key.h"
+
 namespace thomas {
 
+/**
+ * @brief
+ * A fixed-width string, always zero-padded, so that it compares by its bytes
+ * @tparam StringSize the width, a string of exactly this size has no terminator
+ */
 template <size_t StringSize>
 class String {
  public:
@@ -19,17 +26,17 @@ class String {
 
   void SetValue(char *str) {
     memset(data_, 0, sizeof(data_));
-    memcpy(data_, str, sizeof(data_));
+    memcpy(data_, str, strnlen(str, sizeof(data_)));
   }
 
-  std::string GetValue() { return std::string(data_, data_ + strlen(data_)); }
+  std::string GetValue() { return std::string(data_, data_ + strnlen(data_, sizeof(data_))); }
 
-  int CompareWith(const String &rhs) const { return strcmp(data_, rhs.data_); }
+  int CompareWith(const String &rhs) const { return CompareKeyBytes(data_, rhs.data_, StringSize); }
 
   inline int64_t ToString() const { return *reinterpret_cast<int64_t *>(const_cast<char *>(data_)); }
 
   friend std::ostream &operator<<(std::ostream &os, const String &src) {
-    size_t size = strlen(src.data_);
+    size_t size = strnlen(src.data_, sizeof(src.data_));
     for (size_t i = 0; i < size; ++i) {
       os << src.data_[i];
     }
@@ -37,7 +44,7 @@ class String {
   }
 
  private:
-  char data_[StringSize];
+  char data_[StringSize]{};
 };
 
 template <size_t StringSize>
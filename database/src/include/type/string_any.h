@@ -3,6 +3,9 @@
 #include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <type_traits>
+
+#include "type/normalized_key.h"
 
 namespace thomas {
 
@@ -10,10 +13,13 @@ namespace thomas {
  * @brief
  * A class with a string as the first key and a type as the second key
  * type can be whatever you want, however, it should provide some basic compare operators
+ * an int is kept normalized, so that the whole key compares by its bytes
  * @tparam StringSize the size of the string
  */
 template <size_t StringSize, class T>
 class StringAny {
+  static constexpr bool NORMALIZED = std::is_same<T, int>::value;
+
  public:
   StringAny() = default;
   explicit StringAny(const std::string &str, const T &value) { SetValue(str, value); }
@@ -21,34 +27,71 @@ class StringAny {
   void SetValue(const std::string &str, const T &value) {
     memset(data_str_, 0, sizeof(data_str_));
     memcpy(data_str_, str.c_str(), str.size());
-    data_t_ = value;
+    SetAny(value);
   }
 
   void SetValue(char *str, const T &value) {
     memset(data_str_, 0, sizeof(data_str_));
-    memcpy(data_str_, str, sizeof(data_str_));
-    data_t_ = value;
+    memcpy(data_str_, str, strnlen(str, sizeof(data_str_)));
+    SetAny(value);
+  }
+
+  T GetAny() const {
+    if constexpr (NORMALIZED) {
+      return DecodeKeyInt(static_cast<uint32_t>(data_t_));
+    } else {
+      return data_t_;
+    }
   }
 
   int CompareAnyWith(const StringAny &rhs) const {
-    return data_t_ < rhs.data_t_ ? -1 : (data_t_ == rhs.data_t_ ? 0 : 1);
+    if constexpr (NORMALIZED) {
+      return CompareKeyBytes(reinterpret_cast<const char *>(&data_t_), reinterpret_cast<const char *>(&rhs.data_t_),
+                             sizeof(T));
+    } else {
+      return data_t_ < rhs.data_t_ ? -1 : (data_t_ == rhs.data_t_ ? 0 : 1);
+    }
   }
 
-  int CompareStringWith(const StringAny &rhs) const { return strcmp(data_str_, rhs.data_str_); }
+  int CompareStringWith(const StringAny &rhs) const { return CompareKeyBytes(data_str_, rhs.data_str_, StringSize); }
+
+  /* the string first, then the type */
+  int CompareBothWith(const StringAny &rhs) const {
+    if constexpr (NORMALIZED) {
+      static_assert(sizeof(StringAny) == StringSize + sizeof(T), "the fields must be adjacent");
+      return CompareKeyBytes(reinterpret_cast<const char *>(this), reinterpret_cast<const char *>(&rhs),
+                             StringSize + sizeof(T));
+    } else {
+      int result = CompareStringWith(rhs);
+      return result == 0 ? CompareAnyWith(rhs) : result;
+    }
+  }
 
   inline int64_t ToString() const { return *reinterpret_cast<int64_t *>(const_cast<char *>(data_str_)); }
 
   friend std::ostream &operator<<(std::ostream &os, const StringAny &src) {
-    size_t size = strlen(src.data_str_);
+    size_t size = strnlen(src.data_str_, sizeof(src.data_str_));
     os << "(";
     for (size_t i = 0; i < size; ++i) {
       os << src.data_str_[i];
     }
-    os << ", " << src.data_t_ << ")";
+    if constexpr (NORMALIZED) {
+      os << ", " << DecodeKeyInt(static_cast<uint32_t>(src.data_t_)) << ")";
+    } else {
+      os << ", " << src.data_t_ << ")";
+    }
     return os;
   }
 
  private:
+  void SetAny(const T &value) {
+    if constexpr (NORMALIZED) {
+      data_t_ = static_cast<T>(EncodeKeyInt(value));
+    } else {
+      data_t_ = value;
+    }
+  }
+
   char data_str_[StringSize];
   T data_t_;
 };
@@ -76,8 +119,7 @@ class StringAnyComparator {
       case 2:
         return lhs.CompareAnyWith(rhs);
       case 3:
-        temp_result = lhs.CompareStringWith(rhs);
-        return temp_result == 0 ? lhs.CompareAnyWith(rhs) : temp_result;
+        return lhs.CompareBothWith(rhs);
       case 4:
         temp_result = lhs.CompareAnyWith(rhs);
         return temp_result == 0 ? lhs.CompareStringWith(rhs) : temp_result;
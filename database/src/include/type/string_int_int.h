@@ -4,6 +4,7 @@
 #include <cstring>
 #include <iostream>
 
+#include "type/normalized_key.h"
 #include "type/string.h"
 
 namespace thomas {
@@ -11,7 +12,7 @@ namespace thomas {
 /**
  * @brief
  * A class with a string as the first key, a int as the second key, and a int as the third key
- * type can be whatever you want, however, it should provide some basic compare operators
+ * the ints are kept normalized, so that the key compares by its bytes
  * @tparam StringSize the size of the string
  */
 template <size_t StringSize>
@@ -22,37 +23,50 @@ class StringIntInt {
 
   void SetValue(const std::string &str, int first_int, int second_int) {
     str_.SetValue(str);
-    first_int_ = first_int;
-    second_int_ = second_int;
+    first_int_ = EncodeKeyInt(first_int);
+    second_int_ = EncodeKeyInt(second_int);
   }
 
   void SetValue(char *str, int first_int, int second_int) {
     str_.SetValue(str);
-    first_int_ = first_int;
-    second_int_ = second_int;
+    first_int_ = EncodeKeyInt(first_int);
+    second_int_ = EncodeKeyInt(second_int);
   }
 
   int CompareStringWith(const StringIntInt &rhs) const { return str_.CompareWith(rhs.str_); }
 
   int CompareFirstIntWith(const StringIntInt &rhs) const {
-    return first_int_ < rhs.first_int_ ? -1 : (first_int_ == rhs.first_int_ ? 0 : 1);
+    return CompareKeyBytes(reinterpret_cast<const char *>(&first_int_), reinterpret_cast<const char *>(&rhs.first_int_),
+                           sizeof(first_int_));
   }
 
   int CompareSecondIntWith(const StringIntInt &rhs) const {
-    return second_int_ < rhs.second_int_ ? -1 : (second_int_ == rhs.second_int_ ? 0 : 1);
+    return CompareKeyBytes(reinterpret_cast<const char *>(&second_int_),
+                           reinterpret_cast<const char *>(&rhs.second_int_), sizeof(second_int_));
+  }
+
+  /**
+   * @brief
+   * compare the leading fields in one pass
+   * @param field_count 2 for the string and the first int, 3 for all
+   */
+  int CompareLeadingWith(const StringIntInt &rhs, int field_count) const {
+    static_assert(sizeof(StringIntInt) == StringSize + 2 * sizeof(uint32_t), "the fields must be adjacent");
+    return CompareKeyBytes(reinterpret_cast<const char *>(this), reinterpret_cast<const char *>(&rhs),
+                           StringSize + (field_count - 1) * sizeof(uint32_t));
   }
 
   inline int64_t ToString() const { return *reinterpret_cast<int64_t *>(const_cast<char *>(str_)); }
 
   friend std::ostream &operator<<(std::ostream &os, const StringIntInt &src) {
-    os << "(" << src.str_ << "," << src.first_int_ << "," << src.second_int_ << ")";
+    os << "(" << src.str_ << "," << DecodeKeyInt(src.first_int_) << "," << DecodeKeyInt(src.second_int_) << ")";
     return os;
   }
 
  private:
   String<StringSize> str_;
-  int first_int_;
-  int second_int_;
+  uint32_t first_int_;
+  uint32_t second_int_;
 };
 
 /**
@@ -71,20 +85,11 @@ class StringIntIntComparator {
   explicit StringIntIntComparator(int category) : category_(category) {}
 
   int operator()(const StringIntInt<StringSize> &lhs, const StringIntInt<StringSize> &rhs) const {
-    int result = 0;
     switch (category_) {
       case 1:
-        result = lhs.CompareStringWith(rhs);
-        return result == 0 ? lhs.CompareFirstIntWith(rhs) : result;
+        return lhs.CompareLeadingWith(rhs, 2);
       case 2:
-        result = lhs.CompareStringWith(rhs);
-        if (result == 0) {
-          result = lhs.CompareFirstIntWith(rhs);
-        }
-        if (result == 0) {
-          result = lhs.CompareSecondIntWith(rhs);
-        }
-        return result;
+        return lhs.CompareLeadingWith(rhs, 3);
       default:
         return 0;
     }
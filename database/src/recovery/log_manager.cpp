@@ -0,0 +1,540 @@
+#include "recovery/log_manager.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include "container/linked_hashmap.hpp"
+
+namespace thomas {
+
+namespace {
+
+/** the pages are compared a block at a time first, most of a page is the same as its logged image */
+constexpr int COMPARE_BLOCK_SIZE = 256;
+
+void ReadFully(int fd, char *data, int size, off_t offset) {
+  int read_count = 0;
+  while (read_count < size) {
+    ssize_t res = pread(fd, data + read_count, size - read_count, offset + read_count);
+    if (res == -1 && errno == EINTR) {
+      continue;
+    }
+    if (res == -1) {
+      throw std::runtime_error("I/O error while reading");
+    }
+    /* the file ends, the rest is zero like a page never written */
+    if (res == 0) {
+      memset(data + read_count, 0, size - read_count);
+      return;
+    }
+    read_count += res;
+  }
+}
+
+void WriteFully(int fd, const char *data, int size, off_t offset) {
+  int write_count = 0;
+  while (write_count < size) {
+    ssize_t res = pwrite(fd, data + write_count, size - write_count, offset + write_count);
+    if (res == -1 && errno == EINTR) {
+      continue;
+    }
+    if (res <= 0) {
+      throw std::runtime_error("I/O error while writing");
+    }
+    write_count += res;
+  }
+}
+
+template <typename T>
+T Load(const char *data) {
+  T value;
+  memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+template <typename T>
+void Store(char *data, T value) {
+  memcpy(data, &value, sizeof(T));
+}
+
+}  // namespace
+
+/**
+ * @brief
+ * a log manager constructor, the files are recovered here, before any of them is opened by an index
+ * @param log_file the name of the log file
+ */
+LogManager::LogManager(const std::string &log_file) : log_name_(log_file) {
+  log_fd_ = open(log_name_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (log_fd_ == -1) {
+    throw std::runtime_error("can't open log file");
+  }
+  log_buffer_ = new char[LOG_BUFFER_SIZE];
+  flush_buffer_ = new char[LOG_BUFFER_SIZE];
+  Recover();
+  flush_thread_ = std::thread(&LogManager::FlushFunction, this);
+}
+
+LogManager::~LogManager() {
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    is_terminated_ = true;
+  }
+  flush_cv_.notify_one();
+  flush_thread_.join();
+  close(log_fd_);
+  delete[] log_buffer_;
+  delete[] flush_buffer_;
+}
+
+int LogManager::RegisterFile(const std::string &file_name, const Participant &participant) {
+  std::unique_lock<std::mutex> lock(latch_);
+  int file_id = static_cast<int>(files_.size());
+  files_.push_back({file_name, participant, true});
+  ++registered_num_;
+  AppendRecord(&lock, LogRecordType::FILE, file_id, INVALID_PAGE_ID, file_name.data(),
+               static_cast<int>(file_name.size()));
+  return file_id;
+}
+
+void LogManager::UnregisterFile(int file_id) {
+  std::unique_lock<std::mutex> lock(latch_);
+  files_[file_id].is_registered_ = false;
+  files_[file_id].participant_ = nullptr;
+  if (--registered_num_ == 0) {
+    /* every file is written back, nothing in the log is needed any more */
+    WaitDurable(&lock, next_lsn_ - 1);
+    TruncateLog();
+  }
+}
+
+lsn_t LogManager::AppendUpdate(int file_id, page_id_t page_id, char *logged_image, const char *page_data,
+                               bool is_undoable) {
+  /* the changed words, adjacent ones merged into a range */
+  vector<int> ranges;
+  int begin = -1;
+  int end = -1;
+  int copy_num = is_undoable ? 2 : 1;
+  int payload_size = sizeof(int);
+  for (int block = 0; block < PAGE_SIZE; block += COMPARE_BLOCK_SIZE) {
+    if (memcmp(logged_image + block, page_data + block, COMPARE_BLOCK_SIZE) == 0) {
+      continue;
+    }
+    for (int i = block; i < block + COMPARE_BLOCK_SIZE; i += 8) {
+      if (Load<uint64_t>(logged_image + i) == Load<uint64_t>(page_data + i)) {
+        continue;
+      }
+      if (i != end) {
+        if (end != -1) {
+          ranges.push_back(begin);
+          ranges.push_back(end);
+          payload_size += 2 * sizeof(int) + copy_num * (end - begin);
+        }
+        begin = i;
+      }
+      end = i + 8;
+    }
+  }
+  if (end == -1) {
+    return INVALID_LSN;
+  }
+  ranges.push_back(begin);
+  ranges.push_back(end);
+  payload_size += 2 * sizeof(int) + copy_num * (end - begin);
+
+  std::unique_lock<std::mutex> lock(latch_);
+  int size = LOG_RECORD_HEADER_SIZE + payload_size;
+  char *record = Reserve(&lock, size);
+  char *payload = record + LOG_RECORD_HEADER_SIZE;
+  Store<int>(payload, static_cast<int>(ranges.size() / 2));
+  payload += sizeof(int);
+  for (size_t i = 0; i < ranges.size(); i += 2) {
+    int offset = ranges[i];
+    int length = ranges[i + 1] - offset;
+    Store<int>(payload, offset);
+    Store<int>(payload + sizeof(int), length);
+    payload += 2 * sizeof(int);
+    if (is_undoable) {
+      memcpy(payload, logged_image + offset, length);
+      payload += length;
+    }
+    memcpy(payload, page_data + offset, length);
+    payload += length;
+    memcpy(logged_image + offset, page_data + offset, length);
+  }
+  return Seal(record, size, is_undoable ? LogRecordType::UPDATE : LogRecordType::REDO, file_id, page_id);
+}
+
+lsn_t LogManager::AppendRedo(int file_id, page_id_t page_id, int offset, const char *data, int length) {
+  std::unique_lock<std::mutex> lock(latch_);
+  int size = LOG_RECORD_HEADER_SIZE + 3 * sizeof(int) + length;
+  char *record = Reserve(&lock, size);
+  char *payload = record + LOG_RECORD_HEADER_SIZE;
+  Store<int>(payload, 1);
+  Store<int>(payload + sizeof(int), offset);
+  Store<int>(payload + 2 * sizeof(int), length);
+  memcpy(payload + 3 * sizeof(int), data, length);
+  return Seal(record, size, LogRecordType::REDO, file_id, page_id);
+}
+
+void LogManager::Truncate(int file_id) {
+  LogCommit();
+  std::unique_lock<std::mutex> lock(latch_);
+  AppendRecord(&lock, LogRecordType::TRUNCATE, file_id, INVALID_PAGE_ID);
+  lsn_t lsn = AppendRecord(&lock, LogRecordType::COMMIT, -1, INVALID_PAGE_ID);
+  WaitDurable(&lock, lsn);
+}
+
+void LogManager::Commit(bool force) {
+  lsn_t lsn = LogCommit();
+  std::unique_lock<std::mutex> lock(latch_);
+  if (force) {
+    WaitDurable(&lock, lsn);
+  }
+}
+
+void LogManager::CheckpointIfLong() {
+  std::unique_lock<std::mutex> lock(latch_);
+  bool is_long = next_lsn_ >= LOG_CHECKPOINT_SIZE;
+  lock.unlock();
+  if (is_long) {
+    Checkpoint();
+  }
+}
+
+void LogManager::Flush(lsn_t lsn) {
+  if (lsn == INVALID_LSN) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(latch_);
+  flushed_cv_.wait(lock, [this, lsn] { return !IsCommitting(lsn); });
+  /* the commit after the record is the last one at most, it's a bit more than needed for an UPDATE */
+  WaitDurable(&lock, std::max(lsn, last_commit_lsn_));
+}
+
+bool LogManager::IsDurable(lsn_t lsn) {
+  std::unique_lock<std::mutex> lock(latch_);
+  return lsn == INVALID_LSN || (!IsCommitting(lsn) && persistent_lsn_ > std::max(lsn, last_commit_lsn_));
+}
+
+/**
+ * @brief
+ * the checkpoint is a sharp one: after the commit, the participants write back all of their pages and sync the
+ * files, and then no record is needed for the recovery
+ */
+void LogManager::Checkpoint() {
+  lsn_t lsn = LogCommit();
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    WaitDurable(&lock, lsn);
+  }
+  for (size_t i = 0; i < files_.size(); ++i) {
+    if (files_[i].is_registered_) {
+      files_[i].participant_(true);
+    }
+  }
+  std::unique_lock<std::mutex> lock(latch_);
+  WaitDurable(&lock, next_lsn_ - 1);
+  TruncateLog();
+  LogFiles(&lock);
+}
+
+lsn_t LogManager::LogCommit() {
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    is_committing_ = true;
+    commit_begin_lsn_ = next_lsn_;
+    committer_ = std::this_thread::get_id();
+  }
+  for (size_t i = 0; i < files_.size(); ++i) {
+    if (files_[i].is_registered_) {
+      files_[i].participant_(false);
+    }
+  }
+  std::unique_lock<std::mutex> lock(latch_);
+  lsn_t lsn = AppendRecord(&lock, LogRecordType::COMMIT, -1, INVALID_PAGE_ID);
+  is_committing_ = false;
+  flushed_cv_.notify_all();
+  return lsn;
+}
+
+lsn_t LogManager::AppendRecord(std::unique_lock<std::mutex> *lock, LogRecordType type, int file_id,
+                               page_id_t page_id, const char *payload, int payload_size) {
+  int size = LOG_RECORD_HEADER_SIZE + payload_size;
+  char *record = Reserve(lock, size);
+  if (payload_size != 0) {
+    memcpy(record + LOG_RECORD_HEADER_SIZE, payload, payload_size);
+  }
+  return Seal(record, size, type, file_id, page_id);
+}
+
+char *LogManager::Reserve(std::unique_lock<std::mutex> *lock, int size) {
+  while (log_buffer_size_ + size > LOG_BUFFER_SIZE) {
+    CheckFlushError();
+    flush_requested_ = true;
+    flush_cv_.notify_one();
+    flushed_cv_.wait(*lock);
+  }
+  return log_buffer_ + log_buffer_size_;
+}
+
+lsn_t LogManager::Seal(char *record, int size, LogRecordType type, int file_id, page_id_t page_id) {
+  Store<int>(record, size);
+  Store<int>(record + 8, static_cast<int>(type));
+  Store<int>(record + 12, file_id);
+  Store<page_id_t>(record + 16, page_id);
+  /* the checksum covers everything after it, a torn record at the end of the log is found by it */
+  Store<uint32_t>(record + 4, Checksum(record + 8, size - 8));
+  lsn_t lsn = next_lsn_;
+  next_lsn_ += size;
+  log_buffer_size_ += size;
+  if (type == LogRecordType::COMMIT) {
+    last_commit_lsn_ = lsn;
+  }
+  return lsn;
+}
+
+void LogManager::WaitDurable(std::unique_lock<std::mutex> *lock, lsn_t lsn) {
+  if (persistent_lsn_ > lsn) {
+    return;
+  }
+  flush_requested_ = true;
+  flush_cv_.notify_one();
+  flushed_cv_.wait(*lock, [this, lsn] { return persistent_lsn_ > lsn || flush_error_ != nullptr; });
+  CheckFlushError();
+}
+
+void LogManager::CheckFlushError() {
+  if (flush_error_ != nullptr) {
+    std::rethrow_exception(flush_error_);
+  }
+}
+
+void LogManager::LogFiles(std::unique_lock<std::mutex> *lock) {
+  for (size_t i = 0; i < files_.size(); ++i) {
+    if (files_[i].is_registered_) {
+      AppendRecord(lock, LogRecordType::FILE, static_cast<int>(i), INVALID_PAGE_ID, files_[i].name_.data(),
+                   static_cast<int>(files_[i].name_.size()));
+    }
+  }
+}
+
+void LogManager::TruncateLog() {
+  if (ftruncate(log_fd_, 0) == -1 || fdatasync(log_fd_) == -1) {
+    throw std::runtime_error("I/O error while truncating log");
+  }
+  /* the pages are written back, so none of them holds an LSN into the old log */
+  next_lsn_ = 0;
+  persistent_lsn_ = 0;
+  file_size_ = 0;
+  last_commit_lsn_ = INVALID_LSN;
+}
+
+/**
+ * @brief
+ * the flush thread writes and syncs the log buffer every LOG_TIMEOUT ms, or when it's asked to, a group of commits
+ * shares one sync. The buffers are swapped, so the records can be appended while the other buffer is written. An I/O
+ * error stops the thread, and is thrown in the threads waiting for the log.
+ */
+void LogManager::FlushFunction() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    flush_cv_.wait_for(lock, std::chrono::milliseconds(LOG_TIMEOUT),
+                       [this] { return flush_requested_ || is_terminated_; });
+    flush_requested_ = false;
+    if (log_buffer_size_ == 0) {
+      flushed_cv_.notify_all();
+      if (is_terminated_) {
+        break;
+      }
+      continue;
+    }
+    std::swap(log_buffer_, flush_buffer_);
+    int size = log_buffer_size_;
+    lsn_t end = next_lsn_;
+    off_t offset = file_size_;
+    log_buffer_size_ = 0;
+    flushed_cv_.notify_all();
+
+    lock.unlock();
+    try {
+      WriteFully(log_fd_, flush_buffer_, size, offset);
+      if (fdatasync(log_fd_) == -1) {
+        throw std::runtime_error("I/O error while syncing log");
+      }
+    } catch (std::runtime_error &error) {
+      lock.lock();
+      flush_error_ = std::current_exception();
+      flushed_cv_.notify_all();
+      break;
+    }
+    lock.lock();
+    file_size_ += size;
+    persistent_lsn_ = end;
+    flushed_cv_.notify_all();
+  }
+}
+
+/**
+ * @brief
+ * the log is read up to the first broken record. The updates up to the last commit are redone in order, which
+ * repeats the history of every byte written back, then the updates after it are undone in reverse: the bytes they
+ * cover get back their values before the first of them. The pages touched are written and synced at last, and the log
+ * is emptied.
+ */
+void LogManager::Recover() {
+  struct stat log_stat;
+  if (fstat(log_fd_, &log_stat) == -1) {
+    throw std::runtime_error("I/O error while reading log");
+  }
+  int log_size = static_cast<int>(log_stat.st_size);
+  if (log_size == 0) {
+    return;
+  }
+  char *log = new char[log_size];
+  ReadFully(log_fd_, log, log_size, 0);
+
+  vector<int> offsets;
+  int commit_num = 0;
+  for (int offset = 0; offset + LOG_RECORD_HEADER_SIZE <= log_size;) {
+    int size = Load<int>(log + offset);
+    if (size < LOG_RECORD_HEADER_SIZE || size > log_size - offset ||
+        Load<uint32_t>(log + offset + 4) != Checksum(log + offset + 8, size - 8)) {
+      break;
+    }
+    offsets.push_back(offset);
+    if (static_cast<LogRecordType>(Load<int>(log + offset + 8)) == LogRecordType::COMMIT) {
+      commit_num = static_cast<int>(offsets.size());
+    }
+    offset += size;
+  }
+
+  /* the files by their ids, and the pages touched by (file id, page id) */
+  vector<int> fds;
+  linked_hashmap<int64_t, char *> pages;
+  auto page_of = [&](int file_id, page_id_t page_id) {
+    int64_t key = (static_cast<int64_t>(file_id) << 32) | static_cast<uint32_t>(page_id);
+    auto iter = pages.find(key);
+    if (iter != pages.end()) {
+      return iter->second;
+    }
+    char *page = new char[PAGE_SIZE];
+    ReadFully(fds[file_id], page, PAGE_SIZE, static_cast<off_t>(page_id) * PAGE_SIZE);
+    pages.insert({key, page});
+    return page;
+  };
+  auto apply = [&](const char *record, bool is_redo) {
+    int file_id = Load<int>(record + 12);
+    if (file_id < 0 || file_id >= static_cast<int>(fds.size()) || fds[file_id] == -1) {
+      return;
+    }
+    const char *payload = record + LOG_RECORD_HEADER_SIZE;
+    char *page = page_of(file_id, Load<page_id_t>(record + 16));
+    bool has_old = static_cast<LogRecordType>(Load<int>(record + 8)) == LogRecordType::UPDATE;
+    int range_num = Load<int>(payload);
+    payload += sizeof(int);
+    for (int i = 0; i < range_num; ++i) {
+      int offset = Load<int>(payload);
+      int length = Load<int>(payload + sizeof(int));
+      payload += 2 * sizeof(int);
+      memcpy(page + offset, is_redo && has_old ? payload + length : payload, length);
+      payload += has_old ? 2 * length : length;
+    }
+  };
+
+  for (int i = 0; i < static_cast<int>(offsets.size()); ++i) {
+    const char *record = log + offsets[i];
+    int file_id = Load<int>(record + 12);
+    auto type = static_cast<LogRecordType>(Load<int>(record + 8));
+    /* the records after the last commit are not redone, the undo brings back the bytes they cover */
+    if (i >= commit_num && type != LogRecordType::FILE) {
+      continue;
+    }
+    switch (type) {
+      case LogRecordType::FILE: {
+        std::string name(record + LOG_RECORD_HEADER_SIZE, Load<int>(record) - LOG_RECORD_HEADER_SIZE);
+        while (static_cast<int>(fds.size()) <= file_id) {
+          fds.push_back(-1);
+        }
+        if (fds[file_id] == -1) {
+          fds[file_id] = open(name.c_str(), O_RDWR | O_CREAT, 0644);
+          if (fds[file_id] == -1) {
+            throw std::runtime_error("can't open db file");
+          }
+        }
+        break;
+      }
+      case LogRecordType::UPDATE:
+      case LogRecordType::REDO:
+        apply(record, true);
+        break;
+      case LogRecordType::TRUNCATE: {
+        /* the pages of the file are dropped along with it */
+        vector<int64_t> keys;
+        for (auto iter = pages.begin(); iter != pages.end(); ++iter) {
+          if (static_cast<int>(iter->first >> 32) == file_id) {
+            keys.push_back(iter->first);
+          }
+        }
+        for (size_t j = 0; j < keys.size(); ++j) {
+          auto iter = pages.find(keys[j]);
+          delete[] iter->second;
+          pages.erase(iter);
+        }
+        if (file_id < static_cast<int>(fds.size()) && fds[file_id] != -1 && ftruncate(fds[file_id], 0) == -1) {
+          throw std::runtime_error("I/O error while clearing");
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+  /* a truncation is always committed on its own, so only the updates are left to undo */
+  for (int i = static_cast<int>(offsets.size()) - 1; i >= commit_num; --i) {
+    const char *record = log + offsets[i];
+    if (static_cast<LogRecordType>(Load<int>(record + 8)) == LogRecordType::UPDATE) {
+      apply(record, false);
+    }
+  }
+
+  for (auto iter = pages.begin(); iter != pages.end(); ++iter) {
+    WriteFully(fds[iter->first >> 32], iter->second, PAGE_SIZE,
+               static_cast<off_t>(static_cast<page_id_t>(iter->first & 0xFFFFFFFF)) * PAGE_SIZE);
+    delete[] iter->second;
+  }
+  for (size_t i = 0; i < fds.size(); ++i) {
+    if (fds[i] != -1) {
+      if (fdatasync(fds[i]) == -1) {
+        throw std::runtime_error("I/O error while syncing");
+      }
+      close(fds[i]);
+    }
+  }
+  delete[] log;
+  TruncateLog();
+}
+
+uint32_t LogManager::Checksum(const char *data, int size) {
+  uint64_t hash = 0x9E3779B97F4A7C15ULL ^ static_cast<uint64_t>(size);
+  int i = 0;
+  for (; i + 8 <= size; i += 8) {
+    hash = (hash ^ Load<uint64_t>(data + i)) * 0x100000001B3ULL;
+    hash ^= hash >> 29;
+  }
+  for (; i < size; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(data[i])) * 0x100000001B3ULL;
+  }
+  return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+}  // namespace thomas
@@ -1,108 +1,334 @@
 #include "storage/disk/disk_manager.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <cassert>
+#include <cerrno>
 #include <cstring>
 #include <iostream>
+#include <stdexcept>
 #include <string>
-#include <thread>  // NOLINT
 
 #include "common/exceptions.hpp"
 
 namespace thomas {
 
-static char *buffer_used;
-
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file), next_page_id_(0) {
+DiskManager::DiskManager(const std::string &db_file, bool direct_io)
+    : db_fd_(-1), direct_io_(direct_io), file_name_(db_file), next_page_id_(0), free_page_id_(INVALID_PAGE_ID) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     throw std::runtime_error("wrong file format");
   }
+  Open();
+}
+
+DiskManager::~DiskManager() {
+  StopWorker();
+#ifdef THOMAS_HAVE_LIBURING
+  if (ring_ready_) {
+    io_uring_queue_exit(&ring_);
+  }
+#endif
+  ShutDown();
+}
 
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
-      throw std::runtime_error("can't open db file");
+/**
+ * @brief
+ * open the db file, create it if it does not exist
+ */
+void DiskManager::Open() {
+  int flags = O_RDWR | O_CREAT;
+#ifdef O_DIRECT
+  if (direct_io_) {
+    db_fd_ = open(file_name_.c_str(), flags | O_DIRECT, 0644);
+    if (db_fd_ != -1) {
+      return;
     }
+    /* tmpfs and some others reject O_DIRECT */
+    direct_io_ = false;
+  }
+#endif
+  db_fd_ = open(file_name_.c_str(), flags, 0644);
+  if (db_fd_ == -1) {
+    throw std::runtime_error("can't open db file");
   }
-  buffer_used = nullptr;
 }
 
 /**
  * Close all file streams
  */
-void DiskManager::ShutDown() { db_io_.close(); }
+void DiskManager::ShutDown() {
+  if (db_fd_ != -1) {
+    close(db_fd_);
+    db_fd_ = -1;
+  }
+}
 
 /**
  * @brief
  * clear the entire file
  */
 void DiskManager::Clear() {
-  db_io_.close();
-  db_io_.open(file_name_, std::ios::binary | std::ios::trunc | std::ios::out);
-  db_io_.close();
-  db_io_.open(file_name_, std::ios::binary | std::ios::in | std::ios::out);
+  if (ftruncate(db_fd_, 0) == -1) {
+    throw std::runtime_error("I/O error while clearing");
+  }
   next_page_id_ = 0;
+  free_page_id_ = INVALID_PAGE_ID;
+}
+
+/**
+ * @brief
+ * the pages are written without flushing, so sync them here
+ */
+void DiskManager::Sync() {
+  if (fdatasync(db_fd_) == -1) {
+    throw std::runtime_error("I/O error while syncing");
+  }
 }
 
 /**
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    throw std::runtime_error("I/O error while writing");
+  assert(!direct_io_ || reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT == 0);
+  off_t offset = static_cast<off_t>(page_id) * PAGE_SIZE;
+  ssize_t write_count = 0;
+  while (write_count < PAGE_SIZE) {
+    ssize_t res = pwrite(db_fd_, page_data + write_count, PAGE_SIZE - write_count, offset + write_count);
+    if (res == -1 && errno == EINTR) {
+      continue;
+    }
+    /* check for I/O error */
+    if (res <= 0) {
+      throw std::runtime_error("I/O error while writing");
+    }
+    write_count += res;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
-  // set read cursor to offset
-  db_io_.seekp(offset);
-  db_io_.read(page_data, PAGE_SIZE);
-  if (db_io_.bad()) {
-    throw std::runtime_error("I/O error while reading");
-  }
-  // if file ends before reading PAGE_SIZE
-  int read_count = db_io_.gcount();
-  if (read_count < PAGE_SIZE) {
-    db_io_.clear();
+  assert(!direct_io_ || reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT == 0);
+  off_t offset = static_cast<off_t>(page_id) * PAGE_SIZE;
+  ssize_t read_count = 0;
+  while (read_count < PAGE_SIZE) {
+    ssize_t res = pread(db_fd_, page_data + read_count, PAGE_SIZE - read_count, offset + read_count);
+    if (res == -1 && errno == EINTR) {
+      continue;
+    }
+    if (res == -1) {
+      throw std::runtime_error("I/O error while reading");
+    }
+    /* if file ends before reading PAGE_SIZE */
+    if (res == 0) {
+      throw read_less_then_a_page();
+    }
+    read_count += res;
+  }
+}
+
+/**
+ * @brief
+ * serve a request synchronously, used by the I/O thread
+ */
+void DiskManager::Serve(DiskRequest *request) {
+  try {
+    if (request->is_write_) {
+      WritePage(request->page_id_, request->data_);
+    } else {
+      ReadPage(request->page_id_, request->data_);
+    }
+  } catch (read_less_then_a_page &error) {
+    request->error_ = 1;
+  } catch (std::runtime_error &error) {
+    request->error_ = -1;
+  }
+}
+
+void DiskManager::WorkerFunction() {
+  while (true) {
+    DiskRequest *request;
+    {
+      std::unique_lock<std::mutex> lock(io_latch_);
+      request_cv_.wait(lock, [this] { return is_terminated_ || !requests_.empty(); });
+      if (requests_.empty()) {
+        return;
+      }
+      request = requests_.front();
+      requests_.pop_front();
+    }
+    Serve(request);
+    {
+      std::unique_lock<std::mutex> lock(io_latch_);
+      request->done_ = true;
+    }
+    done_cv_.notify_all();
+  }
+}
+
+void DiskManager::StopWorker() {
+  if (!worker_.joinable()) {
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> lock(io_latch_);
+    is_terminated_ = true;
+  }
+  request_cv_.notify_all();
+  worker_.join();
+}
+
+#ifdef THOMAS_HAVE_LIBURING
+/**
+ * @brief
+ * collect the completions in the ring
+ * @param block whether to wait for at least one completion
+ */
+void DiskManager::Reap(bool block) {
+  struct io_uring_cqe *cqe;
+  while ((block ? io_uring_wait_cqe(&ring_, &cqe) : io_uring_peek_cqe(&ring_, &cqe)) == 0) {
+    auto *request = static_cast<DiskRequest *>(io_uring_cqe_get_data(cqe));
+    if (cqe->res < 0) {
+      request->error_ = -1;
+    } else if (cqe->res < PAGE_SIZE) {
+      request->error_ = request->is_write_ ? -1 : 1;
+    }
+    request->done_ = true;
+    io_uring_cqe_seen(&ring_, cqe);
+    block = false;
+  }
+}
+#endif
+
+void DiskManager::Submit(DiskRequest *request) {
+  /* several buffer pool instances might submit at the same time, so the ring is also behind io_latch_ */
+  std::unique_lock<std::mutex> lock(io_latch_);
+  request->done_ = false;
+  request->error_ = 0;
+  if (!async_started_) {
+    async_started_ = true;
+#ifdef THOMAS_HAVE_LIBURING
+    ring_ready_ = io_uring_queue_init(8, &ring_, 0) == 0;
+    if (!ring_ready_)
+#endif
+      worker_ = std::thread(&DiskManager::WorkerFunction, this);
+  }
+
+#ifdef THOMAS_HAVE_LIBURING
+  if (ring_ready_) {
+    struct io_uring_sqe *sqe = io_uring_get_sqe(&ring_);
+    while (sqe == nullptr) {
+      /* the submission queue is full */
+      io_uring_submit(&ring_);
+      Reap(true);
+      sqe = io_uring_get_sqe(&ring_);
+    }
+    off_t offset = static_cast<off_t>(request->page_id_) * PAGE_SIZE;
+    if (request->is_write_) {
+      io_uring_prep_write(sqe, db_fd_, request->data_, PAGE_SIZE, offset);
+    } else {
+      io_uring_prep_read(sqe, db_fd_, request->data_, PAGE_SIZE, offset);
+    }
+    io_uring_sqe_set_data(sqe, request);
+    io_uring_submit(&ring_);
+    return;
+  }
+#endif
+
+  requests_.push_back(request);
+  lock.unlock();
+  request_cv_.notify_one();
+}
+
+bool DiskManager::IsAsyncPreferred() {
+#ifdef THOMAS_HAVE_LIBURING
+  return true;
+#else
+  return direct_io_;
+#endif
+}
+
+bool DiskManager::Poll(DiskRequest *request) {
+#ifdef THOMAS_HAVE_LIBURING
+  if (ring_ready_) {
+    std::unique_lock<std::mutex> lock(io_latch_);
+    Reap(false);
+    return request->done_;
+  }
+#endif
+  std::unique_lock<std::mutex> lock(io_latch_);
+  return request->done_;
+}
+
+void DiskManager::Wait(DiskRequest *request) {
+#ifdef THOMAS_HAVE_LIBURING
+  if (ring_ready_) {
+    std::unique_lock<std::mutex> lock(io_latch_);
+    while (!request->done_) {
+      Reap(true);
+    }
+  }
+#endif
+  {
+    std::unique_lock<std::mutex> lock(io_latch_);
+    done_cv_.wait(lock, [request] { return request->done_; });
+  }
+  if (request->error_ == 1) {
     throw read_less_then_a_page();
-    // std::cerr << "Read less than a page" << std::endl;
-    memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+  }
+  if (request->error_ == -1) {
+    throw std::runtime_error("I/O error in asynchronous request");
   }
 }
 
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * Take the head of the freed pages if any, otherwise keep an increasing counter
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage() {
+  if (free_page_id_ != INVALID_PAGE_ID) {
+    std::scoped_lock lock{free_latch_};
+    page_id_t page_id = free_page_id_;
+    if (page_id != INVALID_PAGE_ID) {
+      alignas(DIRECT_IO_ALIGNMENT) char buffer[PAGE_SIZE];
+      ReadPage(page_id, buffer);
+      free_page_id_ = *reinterpret_cast<page_id_t *>(buffer);
+      return page_id;
+    }
+  }
+  return next_page_id_++;
+}
 
 /**
  * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
- * This does not actually need to do anything for now.
+ * The page is pushed onto the list of freed pages by writing the old head into it
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {}
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  std::scoped_lock lock{free_latch_};
+  alignas(DIRECT_IO_ALIGNMENT) char buffer[PAGE_SIZE];
+  if (!GetFreedPage(page_id, buffer)) {
+    return;
+  }
+  WritePage(page_id, buffer);
+  free_page_id_ = page_id;
+}
+
+bool DiskManager::GetFreedPage(page_id_t page_id, char *page_data) {
+  /* the header page is never freed, and a page beyond the counter is never allocated */
+  if (page_id <= HEADER_PAGE_ID || page_id >= next_page_id_) {
+    return false;
+  }
+  page_id_t next_page_id = free_page_id_;
+  memset(page_data, 0, PAGE_SIZE);
+  memcpy(page_data, &next_page_id, sizeof(page_id_t));
+  return true;
+}
 
 }  // namespace thomas
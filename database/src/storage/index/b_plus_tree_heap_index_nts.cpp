@@ -0,0 +1,189 @@
+#include "storage/index/b_plus_tree_heap_index_nts.h"
+
+#include <algorithm>
+
+#include "common/macros.h"
+
+namespace thomas {
+
+#define BPLUSTREEHEAPINDEXNTS_TYPE BPlusTreeHeapIndexNTS<KeyType, ValueType, KeyComparator>
+
+/**
+ * @brief
+ * a non-thread-safe b+ tree constructor, whose values are kept in a table heap
+ * @param index_name the name of b+ tree, and the heap is in the file with the suffix "_heap"
+ * @param key_comparator the comparator used to compare keys
+ * @param buffer_pool_size the size of the buffer pools, a quarter goes to the tree and the rest to the heap
+ * @param enable_cleaner whether to write back dirty pages in the background
+ * @param replacer_type the replacement policy of the buffer pools
+ * @param enable_swizzling whether the inner pages near the root are kept pinned and reached by pointers
+ * @param log_manager the write-ahead log of both files, nullptr for none
+ * @return INDEX_TEMPLATE_ARGUMENTS
+ */
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREEHEAPINDEXNTS_TYPE::BPlusTreeHeapIndexNTS(const std::string &index_name, const KeyComparator &key_comparator,
+                                                  int buffer_pool_size, bool enable_cleaner,
+                                                  REPLACER_TYPE replacer_type, bool enable_swizzling,
+                                                  LogManager *log_manager) {
+  /* the leaves of RIDs are dense, most of the pool is left for the records */
+  int index_pool_size = std::max(buffer_pool_size / 4, 16);
+  index_ = new BPlusTreeIndexNTS<KeyType, RID, KeyComparator>(
+      index_name, key_comparator, index_pool_size, enable_cleaner, replacer_type, enable_swizzling, log_manager);
+  heap_ = new TableHeap(index_name + "_heap.db", std::max(buffer_pool_size - index_pool_size, 16), replacer_type,
+                        log_manager);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREEHEAPINDEXNTS_TYPE::~BPlusTreeHeapIndexNTS() {
+  delete index_;
+  delete heap_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREEHEAPINDEXNTS_TYPE::Flush() {
+  index_->Flush();
+  heap_->Flush();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREEHEAPINDEXNTS_TYPE::Compact() { index_->Compact(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREEHEAPINDEXNTS_TYPE::IsEmpty() { return index_->IsEmpty(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREEHEAPINDEXNTS_TYPE::Debug() { index_->Debug(); }
+
+/**
+ * @brief
+ * insert a key value pair, a repeated key is considered as modification, and its record is overwritten in place
+ * @param key the key to be inserted
+ * @param value the value to be inserted
+ * @return INDEX_TEMPLATE_ARGUMENTS
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREEHEAPINDEXNTS_TYPE::InsertEntry(const KeyType &key, const ValueType &value) {
+  vector<RID> rids;
+  index_->SearchKey(key, &rids);
+  if (!rids.empty()) {
+    heap_->UpdateRecord(rids[0], reinterpret_cast<const char *>(&value), sizeof(ValueType));
+    return;
+  }
+  index_->InsertEntry(key, heap_->InsertRecord(reinterpret_cast<const char *>(&value), sizeof(ValueType)));
+}
+
+/**
+ * @brief
+ * delete a key value pair and its record, nothing happens if no such entry
+ * @param key
+ * @return INDEX_TEMPLATE_ARGUMENTS
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREEHEAPINDEXNTS_TYPE::DeleteEntry(const KeyType &key) {
+  vector<RID> rids;
+  index_->SearchKey(key, &rids);
+  if (rids.empty()) {
+    return;
+  }
+  heap_->DeleteRecord(rids[0]);
+  index_->DeleteEntry(key);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREEHEAPINDEXNTS_TYPE::ScanKey(const KeyType &key, vector<ValueType> *result,
+                                         const KeyComparator &standby_comparator) {
+  vector<RID> rids;
+  index_->ScanKey(key, &rids, standby_comparator);
+  FetchValues(rids, result);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREEHEAPINDEXNTS_TYPE::SearchKey(const KeyType &key, vector<ValueType> *result) {
+  vector<RID> rids;
+  index_->SearchKey(key, &rids);
+  FetchValues(rids, result);
+}
+
+/**
+ * @brief
+ * change the values of a batch of keys, the RIDs are looked up together, so the keys close to each other share their
+ * descents, and each record is updated in place without another lookup
+ * @param keys the keys sorted in order
+ * @param modifier called on the value of each key found, which changes it
+ * @return the number of keys found
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREEHEAPINDEXNTS_TYPE::ModifyEntries(const vector<KeyType> &keys, const Modifier &modifier) {
+  vector<RID> rids;
+  vector<bool> found;
+  int found_num = index_->MultiGet(keys, &rids, &found);
+  ValueType value;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (!found[i]) {
+      continue;
+    }
+    heap_->GetRecord(rids[i], reinterpret_cast<char *>(&value));
+    modifier(keys[i], &value);
+    heap_->UpdateRecord(rids[i], reinterpret_cast<const char *>(&value), sizeof(ValueType));
+  }
+  return found_num;
+}
+
+/**
+ * @brief
+ * visit the key value pairs with lower <= key <= upper in order, a record is read only when its key is visited
+ * @param lower the smallest key to visit
+ * @param upper the greatest key to visit
+ * @param visitor called on each pair, returns false to stop, and it must not change the index
+ * @return the number of pairs visited
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREEHEAPINDEXNTS_TYPE::Scan(const KeyType &lower, const KeyType &upper, const Visitor &visitor) {
+  ValueType value;
+  return index_->Scan(lower, upper, [&](const KeyType &key, const RID &rid) {
+    heap_->GetRecord(rid, reinterpret_cast<char *>(&value));
+    return visitor(key, value);
+  });
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREEHEAPINDEXNTS_TYPE::ScanKeys(const KeyType &lower, const KeyType &upper, const KeyVisitor &visitor) {
+  return index_->Scan(lower, upper, [&](const KeyType &key, const RID &) { return visitor(key); });
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREEHEAPINDEXNTS_TYPE::ReverseScan(const KeyType &lower, const KeyType &upper, const Visitor &visitor) {
+  ValueType value;
+  return index_->ReverseScan(lower, upper, [&](const KeyType &key, const RID &rid) {
+    heap_->GetRecord(rid, reinterpret_cast<char *>(&value));
+    return visitor(key, value);
+  });
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREEHEAPINDEXNTS_TYPE::ReverseScanKeys(const KeyType &lower, const KeyType &upper,
+                                                const KeyVisitor &visitor) {
+  return index_->ReverseScan(lower, upper, [&](const KeyType &key, const RID &) { return visitor(key); });
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREEHEAPINDEXNTS_TYPE::Clear() {
+  index_->Clear();
+  heap_->Clear();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREEHEAPINDEXNTS_TYPE::Size() { return index_->Size(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREEHEAPINDEXNTS_TYPE::FetchValues(const vector<RID> &rids, vector<ValueType> *result) {
+  ValueType value;
+  for (size_t i = 0; i < rids.size(); ++i) {
+    heap_->GetRecord(rids[i], reinterpret_cast<char *>(&value));
+    result->push_back(value);
+  }
+}
+
+DECLARE_HEAP(BPlusTreeHeapIndexNTS)
+
+}  // namespace thomas
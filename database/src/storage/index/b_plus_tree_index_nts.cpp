@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include <chrono>
+#include <cstdio>
 #include <cstring>
 #include <mutex>
 #include <stdexcept>
@@ -22,16 +23,34 @@ namespace thomas {
  * @param index_name the name of b+ tree
  * @param key_comparator the comparator used to compare keys
  * @param buffer_pool_size the size of the buffer pool
+ * @param enable_cleaner whether to write back dirty pages in the background
+ * @param replacer_type the replacement policy of the buffer pool
+ * @param enable_swizzling whether the inner pages near the root are kept pinned and reached by pointers
+ * @param log_manager the write-ahead log of the pages, nullptr for none
  * @return INDEX_TEMPLATE_ARGUMENTS
  */
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREEINDEXNTS_TYPE::BPlusTreeIndexNTS(const std::string &index_name, const KeyComparator &key_comparator,
-                                          int buffer_pool_size)
-    : key_comparator_(key_comparator), buffer_pool_size_(buffer_pool_size) {
+                                          int buffer_pool_size, bool enable_cleaner, REPLACER_TYPE replacer_type,
+                                          bool enable_swizzling, LogManager *log_manager)
+    : key_comparator_(key_comparator),
+      buffer_pool_size_(buffer_pool_size),
+      enable_swizzling_(enable_swizzling),
+      log_manager_(log_manager) {
   assert(index_name.size() < 32);
   strcpy(index_name_, index_name.c_str());
   disk_manager_ = new DiskManager(index_name + ".db");
-  bpm_ = new BufferPoolManager(buffer_pool_size, disk_manager_, THREAD_SAFE_TYPE::NON_THREAD_SAFE);
+  auto bpm =
+      new BufferPoolManagerInstance(buffer_pool_size, disk_manager_, THREAD_SAFE_TYPE::NON_THREAD_SAFE, replacer_type);
+  if (log_manager_ != nullptr) {
+    file_id_ =
+        log_manager_->RegisterFile(disk_manager_->GetFileName(), [this](bool checkpoint) { Persist(checkpoint); });
+    bpm->SetLogManager(log_manager_, file_id_);
+  }
+  bpm_ = bpm;
+  if (enable_cleaner) {
+    bpm_->StartCleaner();
+  }
 
   /* some restore */
   try {
@@ -45,6 +64,13 @@ BPLUSTREEINDEXNTS_TYPE::BPlusTreeIndexNTS(const std::string &index_name, const K
     if (!header_page_->SearchRecord("size", &size_)) {
       throw metadata_error();
     }
+    page_id_t free_page_id;
+    if (!header_page_->SearchRecord("free_page", &free_page_id)) {
+      /* written before the freed pages were reused */
+      free_page_id = INVALID_PAGE_ID;
+      header_page_->InsertRecord("free_page", free_page_id);
+    }
+    disk_manager_->SetFreePageId(free_page_id);
   } catch (read_less_then_a_page &error) {
     /* complicated here, because the page is not fetched successfully */
     bpm_->UnpinPage(HEADER_PAGE_ID, false);
@@ -54,20 +80,73 @@ BPLUSTREEINDEXNTS_TYPE::BPlusTreeIndexNTS(const std::string &index_name, const K
     header_page_->InsertRecord("index", -1);
     header_page_->InsertRecord("page_amount", 1);
     header_page_->InsertRecord("size", 0);
+    header_page_->InsertRecord("free_page", INVALID_PAGE_ID);
   }
   tree_ = new BPLUSTREENTS_TYPE("index", bpm_, key_comparator_);
+  tree_->SetSwizzling(enable_swizzling_);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREEINDEXNTS_TYPE::~BPlusTreeIndexNTS() {
-  header_page_->UpdateRecord("page_amount", disk_manager_->GetNextPageId());
-  header_page_->UpdateRecord("size", size_);
+  /* the tree unpins its swizzled pages */
+  delete tree_;
+  Flush();
   bpm_->UnpinPage(HEADER_PAGE_ID, true);
-  bpm_->FlushAllPages();
+  if (log_manager_ != nullptr) {
+    log_manager_->UnregisterFile(file_id_);
+  }
   disk_manager_->ShutDown();
   delete disk_manager_;
   delete bpm_;
-  delete tree_;
+}
+
+/**
+ * @brief
+ * checkpoint: write the metadata and all the pages back, then sync the file
+ * @return INDEX_TEMPLATE_ARGUMENTS
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREEINDEXNTS_TYPE::Flush() {
+  SyncHeader();
+  bpm_->FlushAllPages();
+  disk_manager_->Sync();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREEINDEXNTS_TYPE::SyncHeader() {
+  page_id_t page_amount;
+  int size;
+  page_id_t free_page_id;
+  header_page_->SearchRecord("page_amount", &page_amount);
+  header_page_->SearchRecord("size", &size);
+  header_page_->SearchRecord("free_page", &free_page_id);
+  if (page_amount == disk_manager_->GetNextPageId() && size == size_ &&
+      free_page_id == disk_manager_->GetFreePageId()) {
+    return;
+  }
+  header_page_->UpdateRecord("page_amount", disk_manager_->GetNextPageId());
+  header_page_->UpdateRecord("size", size_);
+  header_page_->UpdateRecord("free_page", disk_manager_->GetFreePageId());
+  /* the header page stays pinned, so it's marked dirty by another pin */
+  bpm_->FetchPage(HEADER_PAGE_ID);
+  bpm_->UnpinPage(HEADER_PAGE_ID, true);
+}
+
+/**
+ * @brief
+ * at a commit, the metadata goes into the header page and the changed pages are logged; at a checkpoint, all the
+ * pages are written back and the file is synced
+ * @return INDEX_TEMPLATE_ARGUMENTS
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREEINDEXNTS_TYPE::Persist(bool checkpoint) {
+  if (checkpoint) {
+    bpm_->FlushAllPages();
+    disk_manager_->Sync();
+    return;
+  }
+  SyncHeader();
+  bpm_->LogDirtyPages();
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -89,6 +168,19 @@ void BPLUSTREEINDEXNTS_TYPE::InsertEntry(const KeyType &key, const ValueType &va
   size_ += tree_->Insert(key, value);
 }
 
+/**
+ * @brief
+ * insert key value pairs sorted by unique keys, much faster than inserting them one by one
+ * @param begin the first pair
+ * @param end the one after the last pair
+ * @param fill_factor how full the pages are filled when the tree is built or extended in order
+ * @return INDEX_TEMPLATE_ARGUMENTS
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREEINDEXNTS_TYPE::BulkLoad(const MappingType *begin, const MappingType *end, double fill_factor) {
+  size_ += tree_->BulkLoad(begin, end, fill_factor);
+}
+
 /**
  * @brief
  * delete a key value pair into the b+ tree, nothing happens if no such entry
@@ -117,8 +209,64 @@ void BPLUSTREEINDEXNTS_TYPE::ScanKey(const KeyType &key, vector<ValueType> *resu
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREEINDEXNTS_TYPE::SearchKey(const KeyType &key, vector<ValueType> *result) { tree_->GetValue(key, result); }
 
+/**
+ * @brief
+ * visit the key value pairs with lower <= key <= upper in order, without copying them out
+ * @param lower the smallest key to visit
+ * @param upper the greatest key to visit
+ * @param visitor called on each pair, returns false to stop, and it must not change the index
+ * @return the number of pairs visited
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREEINDEXNTS_TYPE::Scan(const KeyType &lower, const KeyType &upper,
+                                 const typename BPLUSTREENTS_TYPE::Visitor &visitor) {
+  return tree_->Scan(lower, upper, visitor);
+}
+
+/**
+ * @brief
+ * visit the key value pairs with lower <= key <= upper from the greatest key down
+ * @return the number of pairs visited
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREEINDEXNTS_TYPE::ReverseScan(const KeyType &lower, const KeyType &upper,
+                                        const typename BPLUSTREENTS_TYPE::Visitor &visitor) {
+  return tree_->ReverseScan(lower, upper, visitor);
+}
+
+/**
+ * @brief
+ * search a batch of keys sorted in order, which share the descents and the leaves they fall into
+ * @param keys the keys in order
+ * @param result the value of the i-th key is the i-th one, a default one if the key is not found
+ * @param found whether the i-th key is found, could be nullptr if all the keys are known to exist
+ * @return the number of keys found
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREEINDEXNTS_TYPE::MultiGet(const vector<KeyType> &keys, vector<ValueType> *result, vector<bool> *found) {
+  int size = keys.size();
+  if (size == 0) {
+    return 0;
+  }
+  auto *values = new ValueType[size];
+  auto *flags = new bool[size];
+  int found_num = tree_->GetValues(&keys[0], size, values, flags);
+  for (int i = 0; i < size; ++i) {
+    result->push_back(values[i]);
+    if (found != nullptr) {
+      found->push_back(flags[i]);
+    }
+  }
+  delete[] values;
+  delete[] flags;
+  return found_num;
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREEINDEXNTS_TYPE::Clear() {
+  if (log_manager_ != nullptr) {
+    log_manager_->Truncate(file_id_);
+  }
   delete tree_;
   bpm_->Initialize();
   disk_manager_->Clear();
@@ -127,12 +275,62 @@ void BPLUSTREEINDEXNTS_TYPE::Clear() {
   header_page_->InsertRecord("index", -1);
   header_page_->InsertRecord("page_amount", 1);
   header_page_->InsertRecord("size", 0);
+  header_page_->InsertRecord("free_page", INVALID_PAGE_ID);
+  size_ = 0;
   tree_ = new BPLUSTREENTS_TYPE("index", bpm_, key_comparator_);
+  tree_->SetSwizzling(enable_swizzling_);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 int BPLUSTREEINDEXNTS_TYPE::Size() { return size_; }
 
+/**
+ * @brief
+ * offline compaction: the tree is written densely into a new file, which is then copied over the old one, so that the
+ * file shrinks to the pages in use. The file is rewritten without logging, so the log is checkpointed around it
+ * @return INDEX_TEMPLATE_ARGUMENTS
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREEINDEXNTS_TYPE::Compact() {
+  if (log_manager_ != nullptr) {
+    log_manager_->Checkpoint();
+  }
+  std::string compact_file_name = std::string(index_name_) + "_compact.db";
+  auto compact_disk_manager = new DiskManager(compact_file_name);
+  compact_disk_manager->Clear();
+  page_id_t page_amount = tree_->CompactTo(compact_disk_manager);
+
+  /* the header goes last, pointing to the new root */
+  header_page_->UpdateRecord("index", page_amount > 1 ? 1 : INVALID_PAGE_ID);
+  header_page_->UpdateRecord("page_amount", page_amount);
+  header_page_->UpdateRecord("size", size_);
+  header_page_->UpdateRecord("free_page", INVALID_PAGE_ID);
+  compact_disk_manager->WritePage(HEADER_PAGE_ID, header_page_->GetData());
+
+  /* the pool holds the old pages, so it's emptied before the copy */
+  delete tree_;
+  bpm_->Initialize();
+  disk_manager_->Clear();
+  char *buffer = new char[PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < page_amount; ++page_id) {
+    compact_disk_manager->ReadPage(page_id, buffer);
+    disk_manager_->WritePage(page_id, buffer);
+  }
+  delete[] buffer;
+  disk_manager_->SetNextPageId(page_amount);
+  disk_manager_->Sync();
+  compact_disk_manager->ShutDown();
+  delete compact_disk_manager;
+  remove(compact_file_name.c_str());
+
+  header_page_ = static_cast<HeaderPage *>(bpm_->FetchPage(HEADER_PAGE_ID));
+  tree_ = new BPLUSTREENTS_TYPE("index", bpm_, key_comparator_);
+  tree_->SetSwizzling(enable_swizzling_);
+  if (log_manager_ != nullptr) {
+    log_manager_->Checkpoint();
+  }
+}
+
 DECLARE(BPlusTreeIndexNTS)
 
 }  // namespace thomas
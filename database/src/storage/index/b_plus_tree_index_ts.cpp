@@ -17,12 +17,22 @@ namespace thomas {
 
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREEINDEXTS_TYPE::BPlusTreeIndexTS(const std::string &index_name, const KeyComparator &key_comparator,
-                                        ThreadPool *pool, int buffer_pool_size)
+                                        ThreadPool *pool, int buffer_pool_size, bool enable_cleaner,
+                                        int num_instances, REPLACER_TYPE replacer_type)
     : key_comparator_(key_comparator), pool_(pool) {
   assert(index_name.size() < 32);
   strcpy(index_name_, index_name.c_str());
   disk_manager_ = new DiskManager(index_name + ".db");
-  bpm_ = new BufferPoolManager(buffer_pool_size, disk_manager_, THREAD_SAFE_TYPE::THREAD_SAFE);
+  /* several instances split the latch by page id, which pays off when many threads touch the tree */
+  if (num_instances > 1) {
+    bpm_ = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager_, THREAD_SAFE_TYPE::THREAD_SAFE,
+                                         replacer_type);
+  } else {
+    bpm_ = new BufferPoolManagerInstance(buffer_pool_size, disk_manager_, THREAD_SAFE_TYPE::THREAD_SAFE, replacer_type);
+  }
+  if (enable_cleaner) {
+    bpm_->StartCleaner();
+  }
 
   /* some restore */
   try {
@@ -33,6 +43,13 @@ BPLUSTREEINDEXTS_TYPE::BPlusTreeIndexTS(const std::string &index_name, const Key
       throw metadata_error();
     }
     disk_manager_->SetNextPageId(next_page_id);
+    page_id_t free_page_id;
+    if (!header_page_->SearchRecord("free_page", &free_page_id)) {
+      /* written before the freed pages were reused */
+      free_page_id = INVALID_PAGE_ID;
+      header_page_->InsertRecord("free_page", free_page_id);
+    }
+    disk_manager_->SetFreePageId(free_page_id);
   } catch (read_less_then_a_page &error) {
     /* complicated here, because the page is not fetched successfully */
     bpm_->UnpinPage(HEADER_PAGE_ID, false);
@@ -41,26 +58,39 @@ BPLUSTREEINDEXTS_TYPE::BPlusTreeIndexTS(const std::string &index_name, const Key
     header_page_ = static_cast<HeaderPage *>(bpm_->NewPage(&header_page_id));
     header_page_->InsertRecord("index", -1);
     header_page_->InsertRecord("page_amount", 1);
+    header_page_->InsertRecord("free_page", INVALID_PAGE_ID);
   }
   tree_ = new BPLUSTREETS_TYPE("index", bpm_, key_comparator_);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREEINDEXTS_TYPE::~BPlusTreeIndexTS() {
-  header_page_->UpdateRecord("page_amount", disk_manager_->GetNextPageId());
   page_id_t root_page_id;
   header_page_->SearchRecord("index", &root_page_id);
   if (root_page_id != -1) {
     bpm_->UnpinPage(root_page_id, false);
   }
+  Flush();
   bpm_->UnpinPage(HEADER_PAGE_ID, true);
-  bpm_->FlushAllPages();
   disk_manager_->ShutDown();
   delete disk_manager_;
   delete bpm_;
   delete tree_;
 }
 
+/**
+ * @brief
+ * checkpoint: write the metadata and all the pages back, then sync the file
+ * @return INDEX_TEMPLATE_ARGUMENTS
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREEINDEXTS_TYPE::Flush() {
+  header_page_->UpdateRecord("page_amount", disk_manager_->GetNextPageId());
+  header_page_->UpdateRecord("free_page", disk_manager_->GetFreePageId());
+  bpm_->FlushAllPages();
+  disk_manager_->Sync();
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREEINDEXTS_TYPE::Debug() { tree_->Print(bpm_); }
 
@@ -1,6 +1,9 @@
 #include "storage/index/b_plus_tree_nts.h"
 
+#include <algorithm>
+#include <cstring>
 #include <string>
+#include <utility>
 
 #include "common/macros.h"
 #include "storage/page/header_page.h"
@@ -21,6 +24,17 @@ BPLUSTREENTS_TYPE::BPlusTreeNTS(std::string name, BufferPoolManager *buffer_pool
   buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREENTS_TYPE::~BPlusTreeNTS() { Unswizzle(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREENTS_TYPE::SetSwizzling(bool enable_swizzling) {
+  if (!enable_swizzling) {
+    Unswizzle();
+  }
+  enable_swizzling_ = enable_swizzling;
+}
+
 /**
  * Helper function to decide whether current b+tree is empty
  */
@@ -84,7 +98,7 @@ bool BPLUSTREENTS_TYPE::GetValue(const KeyType &key, vector<ValueType> *result,
         clear_up();
         return true;
       }
-      result->push_back(leaf_node->GetItem(index++).second);
+      result->push_back(leaf_node->ValueAt(index++));
     }
     if (index == -1 || index == leaf_node->GetSize()) {
       index = 0;
@@ -104,6 +118,154 @@ bool BPLUSTREENTS_TYPE::GetValue(const KeyType &key, vector<ValueType> *result,
   return true;
 }
 
+/**
+ * @brief
+ * visit the pairs in a range of keys, leaf by leaf, until the upper bound or the visitor stops it, nothing is copied
+ * out of the leaves but the keys
+ * @param lower the smallest key to visit
+ * @param upper the greatest key to visit
+ * @param visitor called on each pair, returns false to stop
+ * @return the number of pairs visited
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREENTS_TYPE::Scan(const KeyType &lower, const KeyType &upper, const Visitor &visitor) {
+  Page *leaf_page = FindLeafPage(lower, false);
+  if (leaf_page == nullptr) {
+    return 0;
+  }
+  LeafPage *leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+  int index = leaf_node->KeyIndex(lower, comparator_);
+  int visited = 0;
+  while (true) {
+    for (; index != -1 && index < leaf_node->GetSize(); ++index) {
+      KeyType key = leaf_node->KeyAt(index);
+      if (comparator_(key, upper) > 0) {
+        buffer_pool_manager_->UnpinPage(leaf_node->GetPageId(), false);
+        return visited;
+      }
+      ++visited;
+      if (!visitor(key, leaf_node->ValueAt(index))) {
+        buffer_pool_manager_->UnpinPage(leaf_node->GetPageId(), false);
+        return visited;
+      }
+    }
+
+    page_id_t next_page_id = leaf_node->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(leaf_node->GetPageId(), false);
+    if (next_page_id == INVALID_PAGE_ID) {
+      return visited;
+    }
+    leaf_node = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(next_page_id)->GetData());
+    index = 0;
+  }
+}
+
+/**
+ * @brief
+ * visit the pairs in a range of keys backward, starting from the leaf the upper bound is routed to, until the lower
+ * bound or the visitor stops it
+ * @param lower the smallest key to visit
+ * @param upper the greatest key to visit
+ * @param visitor called on each pair, returns false to stop
+ * @return the number of pairs visited
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREENTS_TYPE::ReverseScan(const KeyType &lower, const KeyType &upper, const Visitor &visitor) {
+  Page *leaf_page = FindLeafPage(upper, false);
+  if (leaf_page == nullptr) {
+    return 0;
+  }
+  LeafPage *leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+  int index = LastIndexNotAfter(leaf_node, upper);
+  int visited = 0;
+  while (true) {
+    for (; index >= 0; --index) {
+      KeyType key = leaf_node->KeyAt(index);
+      if (comparator_(key, lower) < 0) {
+        buffer_pool_manager_->UnpinPage(leaf_node->GetPageId(), false);
+        return visited;
+      }
+      ++visited;
+      if (!visitor(key, leaf_node->ValueAt(index))) {
+        buffer_pool_manager_->UnpinPage(leaf_node->GetPageId(), false);
+        return visited;
+      }
+    }
+
+    page_id_t prev_page_id = leaf_node->GetPrevPageId();
+    buffer_pool_manager_->UnpinPage(leaf_node->GetPageId(), false);
+    if (prev_page_id == INVALID_PAGE_ID) {
+      return visited;
+    }
+    leaf_node = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(prev_page_id)->GetData());
+    index = leaf_node->GetSize() - 1;
+  }
+}
+
+/**
+ * @brief
+ * the index of the last key not greater than the given one in a leaf
+ * @return -1 if all the keys are greater
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREENTS_TYPE::LastIndexNotAfter(LeafPage *leaf_node, const KeyType &key) {
+  int index = leaf_node->KeyIndex(key, comparator_);
+  if (index == -1) {
+    return leaf_node->GetSize() - 1;
+  }
+  return comparator_(leaf_node->KeyAt(index), key) > 0 ? index - 1 : index;
+}
+
+/**
+ * @brief
+ * look up a batch of keys sorted in order, a leaf stays pinned while the keys fall into it, and the next leaf is tried
+ * before another descent from the root, so the keys close to each other share their visits
+ * @param keys the keys in order
+ * @param size the number of keys
+ * @param values the value of the i-th key is put at values[i]
+ * @param found whether the i-th key is found
+ * @return the number of keys found
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREENTS_TYPE::GetValues(const KeyType *keys, int size, ValueType *values, bool *found) {
+  int found_num = 0;
+  LeafPage *leaf_node = nullptr;
+  auto past = [&](const KeyType &key, LeafPage *node) {
+    return node->GetSize() == 0 || comparator_(key, node->KeyAt(node->GetSize() - 1)) > 0;
+  };
+  for (int i = 0; i < size; ++i) {
+    found[i] = false;
+    if (IsEmpty()) {
+      continue;
+    }
+    if (leaf_node != nullptr && past(keys[i], leaf_node)) {
+      page_id_t next_page_id = leaf_node->GetNextPageId();
+      if (next_page_id == INVALID_PAGE_ID) {
+        /* greater than all the keys */
+        continue;
+      }
+      buffer_pool_manager_->UnpinPage(leaf_node->GetPageId(), false);
+      leaf_node = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(next_page_id)->GetData());
+      if (past(keys[i], leaf_node)) {
+        /* too far away, descend again */
+        buffer_pool_manager_->UnpinPage(leaf_node->GetPageId(), false);
+        leaf_node = nullptr;
+      }
+    }
+    if (leaf_node == nullptr) {
+      leaf_node = reinterpret_cast<LeafPage *>(FindLeafPage(keys[i])->GetData());
+    }
+    if (leaf_node->Lookup(keys[i], &values[i], comparator_)) {
+      found[i] = true;
+      ++found_num;
+    }
+  }
+  if (leaf_node != nullptr) {
+    buffer_pool_manager_->UnpinPage(leaf_node->GetPageId(), false);
+  }
+  return found_num;
+}
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
@@ -186,8 +348,7 @@ bool BPLUSTREENTS_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &valu
     /* split and create a new node */
     /* NOTE: something should be updated here, the node can never be full */
     LeafPage *extra_node = Split<LeafPage>(leaf_node);
-    extra_node->SetNextPageId(leaf_node->GetNextPageId());
-    leaf_node->SetNextPageId(extra_node->GetPageId());
+    LinkAfter(leaf_node, extra_node);
 
     /* insert the smallest key value into parent */
     InsertIntoParent(leaf_node, extra_node->KeyAt(0), extra_node, transaction);
@@ -195,6 +356,184 @@ bool BPLUSTREENTS_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &valu
   return true;
 }
 
+/*****************************************************************************
+ * BULK LOADING
+ *****************************************************************************/
+/**
+ * @brief
+ * the number of entries a page is filled with when the keys come in order, at least 2 so that the levels shrink
+ */
+static int FillOf(int max_size, double fill_factor) {
+  return std::max(2, std::min(max_size - 1, static_cast<int>(fill_factor * (max_size - 1))));
+}
+
+/**
+ * @brief
+ * insert key & value pairs sorted by unique keys, a repeated key is considered as modification
+ * @param begin the first pair
+ * @param end the one after the last pair
+ * @param fill_factor how full the pages are filled, the rest is left for the later inserts
+ * @return the number of new keys
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREENTS_TYPE::BulkLoad(const MappingType *begin, const MappingType *end, double fill_factor) {
+  if (begin == end) {
+    return 0;
+  }
+  if (IsEmpty()) {
+    BuildBottomUp(begin, end, fill_factor);
+    return end - begin;
+  }
+
+  int fill = FillOf(leaf_max_size_, fill_factor);
+  int inserted = 0;
+  while (begin != end) {
+    LeafPage *leaf_node = reinterpret_cast<LeafPage *>(FindLeafPage(begin->first)->GetData());
+    KeyType bound;
+    bool bounded = UpperBoundOf(leaf_node, &bound);
+
+    /* all the pairs below the bound go into this leaf, or into the new leaves after it */
+    while (begin != end && (!bounded || comparator_(begin->first, bound) < 0)) {
+      int size = leaf_node->GetSize();
+      if (size >= fill && comparator_(begin->first, leaf_node->KeyAt(size - 1)) > 0) {
+        /* past the end of a filled leaf, a new leaf is linked after it, which takes the rest below the bound */
+        Unswizzle();
+        LeafPage *extra_node = NewNode<LeafPage>(leaf_node->GetParentPageId(), IndexPageType::LEAF_PAGE);
+        page_id_t extra_page_id = extra_node->GetPageId();
+        LinkAfter(leaf_node, extra_node);
+        InsertIntoParent(leaf_node, begin->first, extra_node);
+        leaf_node = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(extra_page_id)->GetData());
+      }
+
+      inserted += leaf_node->Insert(begin->first, begin->second, comparator_) != -1;
+      ++begin;
+      if (leaf_node->GetSize() == leaf_node->GetMaxSize()) {
+        /* full in the middle, split it like a single insert, and descend again for the rest */
+        LeafPage *extra_node = Split<LeafPage>(leaf_node);
+        LinkAfter(leaf_node, extra_node);
+        InsertIntoParent(leaf_node, extra_node->KeyAt(0), extra_node);
+        leaf_node = nullptr;
+        break;
+      }
+    }
+    if (leaf_node != nullptr) {
+      buffer_pool_manager_->UnpinPage(leaf_node->GetPageId(), true);
+    }
+  }
+  return inserted;
+}
+
+/**
+ * @brief
+ * build the tree level by level from the leaves, the number of nodes on each level is planned first, and the entries
+ * of a level are spread evenly among its nodes, so none is left nearly empty at the end
+ * only the rightmost node of each level is pinned, a new node is appended to the rightmost one above, and the pages
+ * are written once in key order
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREENTS_TYPE::BuildBottomUp(const MappingType *begin, const MappingType *end, double fill_factor) {
+  Unswizzle();
+
+  /* the number of entries and nodes on each level, from the leaves up to the root */
+  vector<int> entry_num;
+  vector<int> node_num;
+  int entries = end - begin;
+  int fill = FillOf(leaf_max_size_, fill_factor);
+  while (true) {
+    int nodes = (entries + fill - 1) / fill;
+    entry_num.push_back(entries);
+    node_num.push_back(nodes);
+    if (nodes == 1) {
+      break;
+    }
+    entries = nodes;
+    fill = FillOf(internal_max_size_, fill_factor);
+  }
+  int height = node_num.size();
+  auto planned_size = [&](int level, int index) {
+    return entry_num[level] / node_num[level] + (index < entry_num[level] % node_num[level]);
+  };
+
+  /* the rightmost inner node of each level, and the number of nodes made on each level */
+  vector<InternalPage *> rightmost;
+  vector<int> made;
+  for (int level = 0; level < height; ++level) {
+    rightmost.push_back(nullptr);
+    made.push_back(0);
+  }
+
+  LeafPage *prev_node = nullptr;
+  const MappingType *item = begin;
+  for (int index = 0; index < node_num[0]; ++index) {
+    /* the lowest inner level with room, those below it need new nodes, and so does the root at first */
+    int level = 1;
+    while (level < height &&
+           (rightmost[level] == nullptr || rightmost[level]->GetSize() == planned_size(level, made[level] - 1))) {
+      ++level;
+    }
+    for (--level; level >= 1; --level) {
+      page_id_t parent_page_id = level + 1 < height ? rightmost[level + 1]->GetPageId() : INVALID_PAGE_ID;
+      InternalPage *node = NewNode<InternalPage>(parent_page_id, IndexPageType::INTERNAL_PAGE);
+      if (level + 1 < height) {
+        rightmost[level + 1]->Append(item->first, node->GetPageId());
+      }
+      if (rightmost[level] != nullptr) {
+        buffer_pool_manager_->UnpinPage(rightmost[level]->GetPageId(), true);
+      }
+      rightmost[level] = node;
+      ++made[level];
+    }
+
+    LeafPage *leaf_node = NewNode<LeafPage>(height > 1 ? rightmost[1]->GetPageId() : INVALID_PAGE_ID,
+                                            IndexPageType::LEAF_PAGE);
+    if (height > 1) {
+      rightmost[1]->Append(item->first, leaf_node->GetPageId());
+    }
+    int size = planned_size(0, index);
+    leaf_node->Append(item, size);
+    item += size;
+    if (prev_node != nullptr) {
+      prev_node->SetNextPageId(leaf_node->GetPageId());
+      leaf_node->SetPrevPageId(prev_node->GetPageId());
+      buffer_pool_manager_->UnpinPage(prev_node->GetPageId(), true);
+    }
+    prev_node = leaf_node;
+  }
+
+  buffer_pool_manager_->UnpinPage(prev_node->GetPageId(), true);
+  root_page_id_ = height > 1 ? rightmost[height - 1]->GetPageId() : prev_node->GetPageId();
+  for (int level = 1; level < height; ++level) {
+    buffer_pool_manager_->UnpinPage(rightmost[level]->GetPageId(), true);
+  }
+  UpdateRootPageId(0);
+}
+
+/**
+ * @brief
+ * the separator right after a node in its ancestors, which is an upper bound of the keys routed into it
+ * @return false if the node is the rightmost one on its level, which has no bound
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREENTS_TYPE::UpperBoundOf(BPlusTreePage *node, KeyType *bound) {
+  page_id_t child_page_id = node->GetPageId();
+  page_id_t parent_page_id = node->GetParentPageId();
+  while (parent_page_id != INVALID_PAGE_ID) {
+    auto parent_node = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(parent_page_id)->GetData());
+    int index = parent_node->ValueIndex(child_page_id);
+    bool found = index + 1 < parent_node->GetSize();
+    if (found) {
+      *bound = parent_node->KeyAt(index + 1);
+    }
+    child_page_id = parent_page_id;
+    parent_page_id = parent_node->GetParentPageId();
+    buffer_pool_manager_->UnpinPage(child_page_id, false);
+    if (found) {
+      return true;
+    }
+  }
+  return false;
+}
+
 /**
  * @brief
  * Split input page and return newly created page.
@@ -203,6 +542,9 @@ bool BPLUSTREENTS_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &valu
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 N *BPLUSTREENTS_TYPE::Split(N *node) {
+  /* the child indexes of the parent are going to shift */
+  Unswizzle();
+
   /* the compiler cannot handle something exquisite, so I have to point out their types */
   if (node->IsLeafPage()) {
     LeafPage *curr_node = reinterpret_cast<LeafPage *>(node);
@@ -219,6 +561,32 @@ N *BPLUSTREENTS_TYPE::Split(N *node) {
   return res_node;
 }
 
+/**
+ * @brief
+ * link a new leaf right after a leaf in both directions
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREENTS_TYPE::LinkAfter(LeafPage *leaf_node, LeafPage *extra_node) {
+  extra_node->SetNextPageId(leaf_node->GetNextPageId());
+  extra_node->SetPrevPageId(leaf_node->GetPageId());
+  leaf_node->SetNextPageId(extra_node->GetPageId());
+  SetPrevOf(extra_node->GetNextPageId(), extra_node->GetPageId());
+}
+
+/**
+ * @brief
+ * point the prev link of a leaf to another one, nothing happens if there is no such leaf
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREENTS_TYPE::SetPrevOf(page_id_t page_id, page_id_t prev_page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  LeafPage *leaf_node = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(page_id)->GetData());
+  leaf_node->SetPrevPageId(prev_page_id);
+  buffer_pool_manager_->UnpinPage(page_id, true);
+}
+
 /**
  * Insert key & value pair into internal page after split
  * @param   old_node      input page from split() method
@@ -305,6 +673,9 @@ bool BPLUSTREENTS_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction
     return true;
   }
 
+  /* inner pages might be merged, deleted or have their children moved */
+  Unswizzle();
+
   if (node->IsRootPage()) {
     return AdjustRoot(node);
   }
@@ -362,13 +733,16 @@ bool BPLUSTREENTS_TYPE::Coalesce(N **neighbor_node, N **node,
     LeafPage *prev_node = reinterpret_cast<LeafPage *>(*neighbor_node);
     curr_node->MoveAllTo(prev_node);
     prev_node->SetNextPageId(curr_node->GetNextPageId());
+    SetPrevOf(curr_node->GetNextPageId(), prev_node->GetPageId());
   }
 
   (*parent)->Remove(index);
 
-  /* unpin */
+  /* unpin, and the emptied node is given back to the disk manager */
+  page_id_t node_page_id = (*node)->GetPageId();
   buffer_pool_manager_->UnpinPage((*neighbor_node)->GetPageId(), true);  // neighbor_node is unpinned
-  buffer_pool_manager_->UnpinPage((*node)->GetPageId(), true);           // node is unpinned
+  buffer_pool_manager_->UnpinPage(node_page_id, false);                  // node is unpinned
+  buffer_pool_manager_->DeletePage(node_page_id);
 
   return CoalesceOrRedistribute(*parent, transaction);
 }
@@ -476,6 +850,53 @@ bool BPLUSTREENTS_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
   return false;
 }
 
+/*****************************************************************************
+ * COMPACTION
+ *****************************************************************************/
+/**
+ * @brief
+ * write the tree into another file from page 1 on, in breadth-first order, so that the freed pages are left out, the
+ * children of a page are consecutive, and so are the leaves, whose next page is simply the one after
+ * @param disk_manager the disk manager of the new file
+ * @return the number of pages used, the header page included
+ */
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t BPLUSTREENTS_TYPE::CompactTo(DiskManager *disk_manager) {
+  if (IsEmpty()) {
+    return 1;
+  }
+  Unswizzle();
+
+  /* the old page ids with the new ids of their parents, the new id of the i-th one is i + 1 */
+  vector<std::pair<page_id_t, page_id_t>> queue;
+  queue.push_back(std::make_pair(root_page_id_, INVALID_PAGE_ID));
+  char *buffer = new char[PAGE_SIZE];
+  for (size_t head = 0; head < queue.size(); ++head) {
+    page_id_t page_id = static_cast<page_id_t>(head) + 1;
+    Page *page = buffer_pool_manager_->FetchPage(queue[head].first);
+    memcpy(buffer, page->GetData(), PAGE_SIZE);
+    buffer_pool_manager_->UnpinPage(queue[head].first, false);
+
+    BPlusTreePage *node = reinterpret_cast<BPlusTreePage *>(buffer);
+    node->SetPageId(page_id);
+    node->SetParentPageId(queue[head].second);
+    if (node->IsLeafPage()) {
+      LeafPage *leaf_node = reinterpret_cast<LeafPage *>(buffer);
+      leaf_node->SetNextPageId(leaf_node->GetNextPageId() == INVALID_PAGE_ID ? INVALID_PAGE_ID : page_id + 1);
+      leaf_node->SetPrevPageId(leaf_node->GetPrevPageId() == INVALID_PAGE_ID ? INVALID_PAGE_ID : page_id - 1);
+    } else {
+      InternalPage *internal_node = reinterpret_cast<InternalPage *>(buffer);
+      for (int i = 0; i < internal_node->GetSize(); ++i) {
+        queue.push_back(std::make_pair(internal_node->ValueAt(i), page_id));
+        internal_node->SetValueAt(i, static_cast<page_id_t>(queue.size()));
+      }
+    }
+    disk_manager->WritePage(page_id, buffer);
+  }
+  delete[] buffer;
+  return static_cast<page_id_t>(queue.size()) + 1;
+}
+
 /*****************************************************************************
  * INDEX ITERATOR
  *****************************************************************************/
@@ -512,6 +933,22 @@ INDEXITERATOR_TYPE BPLUSTREENTS_TYPE::Begin(const KeyType &key) {
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREENTS_TYPE::end() { return INDEXITERATOR_TYPE(nullptr, 0, buffer_pool_manager_); }
 
+/**
+ * @brief
+ * input parameter is high key, find the last key not greater than it, which may be in the previous leaf
+ * @return : index iterator, which is the end if there is no such key
+ */
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREENTS_TYPE::RBegin(const KeyType &key) {
+  Page *leaf_page = FindLeafPage(key);
+  if (leaf_page == nullptr) {
+    return end();
+  }
+  LeafPage *leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+  INDEXITERATOR_TYPE iterator(leaf_node, LastIndexNotAfter(leaf_node, key) + 1, buffer_pool_manager_);
+  return --iterator;
+}
+
 /*****************************************************************************
  * UTILITIES AND DEBUG
  *****************************************************************************/
@@ -525,7 +962,15 @@ Page *BPLUSTREENTS_TYPE::FindLeafPage(const KeyType &key, bool leftMost, bool ri
   if (root_page_id_ == INVALID_PAGE_ID) {
     return nullptr;
   }
-  Page *next_page = buffer_pool_manager_->FetchPage(root_page_id_);
+  if (enable_swizzling_) {
+    return FindLeafPageSwizzled(key, leftMost, rightMost);
+  }
+  return FindLeafPageFrom(buffer_pool_manager_->FetchPage(root_page_id_), key, leftMost, rightMost);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREENTS_TYPE::FindLeafPageFrom(Page *page, const KeyType &key, bool leftMost, bool rightMost) {
+  Page *next_page = page;
 
   BPlusTreePage *test_node = reinterpret_cast<BPlusTreePage *>(next_page->GetData());
   if (test_node->IsLeafPage()) {
@@ -533,9 +978,9 @@ Page *BPLUSTREENTS_TYPE::FindLeafPage(const KeyType &key, bool leftMost, bool ri
   }
 
   InternalPage *internal_node = reinterpret_cast<InternalPage *>(next_page->GetData());
-  page_id_t last_page_id = root_page_id_;
+  page_id_t last_page_id = next_page->GetPageId();
 
-  /* traverse down from root */
+  /* traverse down */
   while (true) {
     /* find the way down */
     page_id_t next_page_id = leftMost ? internal_node->ValueAt(0)
@@ -560,6 +1005,77 @@ Page *BPLUSTREENTS_TYPE::FindLeafPage(const KeyType &key, bool leftMost, bool ri
   }
 }
 
+/**
+ * @brief
+ * find the leaf page through the swizzled inner pages, which are pinned and reached by pointers. The inner pages met
+ * on the way are swizzled until SWIZZLE_CAPACITY, after which the descent goes on through the buffer pool. The leaf
+ * page is pinned once for the caller, as FindLeafPage does.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREENTS_TYPE::FindLeafPageSwizzled(const KeyType &key, bool leftMost, bool rightMost) {
+  if (swizzle_root_ == nullptr) {
+    Page *root_page = buffer_pool_manager_->FetchPage(root_page_id_);
+    if (reinterpret_cast<BPlusTreePage *>(root_page->GetData())->IsLeafPage()) {
+      /* a leaf is never swizzled */
+      return root_page;
+    }
+    swizzle_root_ = NewSwizzleNode(root_page);
+  }
+
+  SwizzleNode *node = swizzle_root_;
+  while (true) {
+    InternalPage *internal_node = reinterpret_cast<InternalPage *>(node->page_->GetData());
+    int index = leftMost ? 0
+                         : (rightMost ? internal_node->GetSize() - 1 : internal_node->LookupIndex(key, comparator_));
+
+    /* the hot path, no buffer pool at all */
+    if (node->children_[index] != nullptr) {
+      node = node->children_[index];
+      continue;
+    }
+
+    Page *child_page = buffer_pool_manager_->FetchPage(internal_node->ValueAt(index));
+    if (reinterpret_cast<BPlusTreePage *>(child_page->GetData())->IsLeafPage()) {
+      return child_page;
+    }
+    if (swizzled_num_ >= SWIZZLE_CAPACITY) {
+      return FindLeafPageFrom(child_page, key, leftMost, rightMost);
+    }
+
+    /* keep the pin, the page stays in the buffer pool as long as it's swizzled */
+    node->children_[index] = NewSwizzleNode(child_page);
+    node = node->children_[index];
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+typename BPLUSTREENTS_TYPE::SwizzleNode *BPLUSTREENTS_TYPE::NewSwizzleNode(Page *page) {
+  ++swizzled_num_;
+  /* an inner page holds at most internal_max_size_ + 1 children */
+  return new SwizzleNode{page, new SwizzleNode *[internal_max_size_ + 1]()};
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREENTS_TYPE::DeleteSwizzleNode(SwizzleNode *node) {
+  for (int i = 0; i <= internal_max_size_; ++i) {
+    if (node->children_[i] != nullptr) {
+      DeleteSwizzleNode(node->children_[i]);
+    }
+  }
+  buffer_pool_manager_->UnpinPage(node->page_->GetPageId(), false);
+  delete[] node->children_;
+  delete node;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREENTS_TYPE::Unswizzle() {
+  if (swizzle_root_ != nullptr) {
+    DeleteSwizzleNode(swizzle_root_);
+    swizzle_root_ = nullptr;
+  }
+  swizzled_num_ = 0;
+}
+
 /**
  * @brief
  * update/Insert root page id in header page(where page_id = 0, header_page is
@@ -595,7 +1111,7 @@ void BPLUSTREENTS_TYPE::ToString(BPlusTreePage *page, BufferPoolManager *bpm) co
   if (page->IsLeafPage()) {
     LeafPage *leaf = reinterpret_cast<LeafPage *>(page);
     std::cout << "Leaf Page: " << leaf->GetPageId() << " parent: " << leaf->GetParentPageId()
-              << " next: " << leaf->GetNextPageId() << std::endl;
+              << " next: " << leaf->GetNextPageId() << " prev: " << leaf->GetPrevPageId() << std::endl;
     for (int i = 0; i < leaf->GetSize(); i++) {
       std::cout << leaf->KeyAt(i) << ",";
     }
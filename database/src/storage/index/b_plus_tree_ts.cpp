@@ -94,7 +94,7 @@ bool BPLUSTREETS_TYPE::GetValue(const KeyType &key, vector<ValueType> *result, c
         transaction->Unlock();
         return true;
       }
-      result->push_back(leaf_node->GetItem(index++).second);
+      result->push_back(leaf_node->ValueAt(index++));
     }
     if (index == -1 || index == leaf_node->GetSize()) {
       index = 0;
@@ -262,7 +262,9 @@ bool BPLUSTREETS_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value
     /* NOTE: something should be updated here, the node can never be full */
     LeafPage *extra_node = Split<LeafPage>(leaf_node);
     extra_node->SetNextPageId(leaf_node->GetNextPageId());
+    extra_node->SetPrevPageId(leaf_node->GetPageId());
     leaf_node->SetNextPageId(extra_node->GetPageId());
+    SetPrevOf(extra_node->GetNextPageId(), extra_node->GetPageId());
 
     /* insert the smallest key value into parent */
     InsertIntoParent(leaf_node, extra_node->KeyAt(0), extra_node, transaction);
@@ -296,6 +298,24 @@ N *BPLUSTREETS_TYPE::Split(N *node) {
   return res_node;
 }
 
+/**
+ * @brief
+ * point the prev link of a leaf to another one, nothing happens if there is no such leaf
+ * the leaf on its left is write latched by the caller, and the latches are always taken from left to right among the
+ * siblings, so that it cannot deadlock
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREETS_TYPE::SetPrevOf(page_id_t page_id, page_id_t prev_page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  page->WLatch();
+  reinterpret_cast<LeafPage *>(page->GetData())->SetPrevPageId(prev_page_id);
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, true);
+}
+
 /**
  * Insert key & value pair into internal page after split
  * @param   old_node      input page from split() method
@@ -505,6 +525,7 @@ bool BPLUSTREETS_TYPE::Coalesce(N **neighbor_node, N **node,
     LeafPage *prev_node = reinterpret_cast<LeafPage *>(*neighbor_node);
     curr_node->MoveAllTo(prev_node);
     prev_node->SetNextPageId(curr_node->GetNextPageId());
+    SetPrevOf(curr_node->GetNextPageId(), prev_node->GetPageId());
   }
 
   (*parent)->Remove(index);
@@ -878,7 +899,7 @@ void BPLUSTREETS_TYPE::ToString(BPlusTreePage *page, BufferPoolManager *bpm) con
   if (page->IsLeafPage()) {
     LeafPage *leaf = reinterpret_cast<LeafPage *>(page);
     std::cout << "Leaf Page: " << leaf->GetPageId() << " parent: " << leaf->GetParentPageId()
-              << " next: " << leaf->GetNextPageId() << std::endl;
+              << " next: " << leaf->GetNextPageId() << " prev: " << leaf->GetPrevPageId() << std::endl;
     for (int i = 0; i < leaf->GetSize(); i++) {
       std::cout << leaf->KeyAt(i) << ",";
     }
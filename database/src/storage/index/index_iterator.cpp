@@ -32,7 +32,7 @@ INDEX_TEMPLATE_ARGUMENTS
 bool INDEXITERATOR_TYPE::isEnd() { return ptr_ == nullptr; }
 
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &INDEXITERATOR_TYPE::operator*() { return ptr_->GetItem(index_); }
+MappingType INDEXITERATOR_TYPE::operator*() { return ptr_->GetItem(index_); }
 
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
@@ -56,6 +56,29 @@ INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
   return *this;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator--() {
+  --index_;
+  if (index_ < 0) {
+    page_id_t prev_page_id = ptr_->GetPrevPageId();
+
+    /* please remember to unpin */
+    buffer_pool_manager_->UnpinPage(ptr_->GetPageId(), false);
+
+    /* reach the end */
+    if (prev_page_id == INVALID_PAGE_ID) {
+      ptr_ = nullptr;
+      index_ = 0;
+      return *this;
+    }
+
+    Page *prev_page = buffer_pool_manager_->FetchPage(prev_page_id);
+    ptr_ = reinterpret_cast<LeafPage *>(prev_page->GetData());
+    index_ = ptr_->GetSize() - 1;
+  }
+  return *this;
+}
+
 DECLARE(IndexIterator)
 
 }  // namespace thomas
@@ -59,29 +59,45 @@ int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const {
 INDEX_TEMPLATE_ARGUMENTS
 ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const { return array[index].second; }
 
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetValueAt(int index, const ValueType &value) { array[index].second = value; }
+
 /*****************************************************************************
  * LOOKUP
  *****************************************************************************/
 /**
  * @brief
- * find and return the child pointer by given key
+ * find and return the index of the child pointer by given key
  */
 INDEX_TEMPLATE_ARGUMENTS
-ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyComparator &comparator) const {
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::LookupIndex(const KeyType &key, const KeyComparator &comparator) const {
   int l = 1;
   int r = GetSize() - 1;
   int child_index = GetSize() - 1;
 
   while (l <= r) {
     int mid = (l + r) >> 1;
-    if (comparator(key, KeyAt(mid)) < 0) {
+    /* both of the possible next probes are fetched while this one is compared */
+    __builtin_prefetch(&array[(l + mid - 1) >> 1].first);
+    __builtin_prefetch(&array[(mid + 1 + r) >> 1].first);
+    /* compared in place, the keys can be large */
+    if (comparator(key, array[mid].first) < 0) {
       child_index = mid - 1;
       r = mid - 1;
     } else {
       l = mid + 1;
     }
   }
-  return array[child_index].second;
+  return child_index;
+}
+
+/**
+ * @brief
+ * find and return the child pointer by given key
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyComparator &comparator) const {
+  return array[LookupIndex(key, comparator)].second;
 }
 
 /*****************************************************************************
@@ -127,6 +143,17 @@ int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(const ValueType &old_value,
   return GetSize();
 }
 
+/**
+ * @brief
+ * append a child after all the others, used when the tree is built bottom-up
+ * NOTE: the parent page id of the child is not set here
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Append(const KeyType &key, const ValueType &value) {
+  array[GetSize()] = MappingType{key, value};
+  IncreaseSize(1);
+}
+
 /*****************************************************************************
  * SPLIT
  *****************************************************************************/
@@ -1,5 +1,6 @@
 #include "storage/page/b_plus_tree_leaf_page.h"
 
+#include <algorithm>
 #include <sstream>
 #include <stdexcept>
 
@@ -21,6 +22,7 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, in
   SetParentPageId(parent_id);
   SetMaxSize(max_size);
   SetNextPageId(INVALID_PAGE_ID);
+  SetPrevPageId(INVALID_PAGE_ID);
   SetPageType(IndexPageType::LEAF_PAGE);
   SetSize(0);
 }
@@ -37,18 +39,34 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) { next_pa
 
 /**
  * @brief
- * helper method to find the first index i so that array[i].first >= key
+ * helper methods to set/get prev page id
+ */
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t B_PLUS_TREE_LEAF_PAGE_TYPE::GetPrevPageId() const { return prev_page_id_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetPrevPageId(page_id_t prev_page_id) { prev_page_id_ = prev_page_id; }
+
+/**
+ * @brief
+ * helper method to find the first index i so that the i-th key >= key
+ * the keys are contiguous, and both of the possible next probes are prefetched while a key is compared, so that the
+ * cache misses on a cold page overlap instead of following each other
  * NOTE: This method is only used when generating index iterator
  * @return -1 if not find
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparator &comparator) const {
+  const KeyType *keys = KeyArray();
   int l = 0;
   int r = GetSize() - 1;
   int index = -1;
   while (l <= r) {
     int mid = (l + r) >> 1;
-    if (comparator(KeyAt(mid), key) >= 0) {
+    __builtin_prefetch(keys + ((l + mid - 1) >> 1));
+    __builtin_prefetch(keys + ((mid + 1 + r) >> 1));
+    /* compared in place, the keys can be large */
+    if (comparator(keys[mid], key) >= 0) {
       r = mid - 1;
       index = mid;
     } else {
@@ -64,7 +82,10 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparator
  * NOTE: Be aware of invalid index
  */
 INDEX_TEMPLATE_ARGUMENTS
-KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const { return array[index].first; }
+KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const { return KeyArray()[index]; }
+
+INDEX_TEMPLATE_ARGUMENTS
+const ValueType &B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAt(int index) const { return ValueArray()[index]; }
 
 /**
  * @brief
@@ -72,7 +93,7 @@ KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const { return array[index]
  * NOTE: Be aware of invalid index
  */
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) { return array[index]; }
+MappingType B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) { return MappingType{KeyArray()[index], ValueArray()[index]}; }
 
 /*****************************************************************************
  * INSERTION
@@ -88,29 +109,47 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &valu
     return -1;
   }
 
+  KeyType *keys = KeyArray();
+  ValueType *values = ValueArray();
   int index = KeyIndex(key, comparator);
   if (index == -1) {
     /* none is bigger */
-    array[GetSize()] = MappingType{key, value};
+    keys[GetSize()] = key;
+    values[GetSize()] = value;
     IncreaseSize(1);
     return GetSize();
   }
 
   /* duplicate key, but I just want to modify it */
-  if (!comparator(key, KeyAt(index))) {
-    array[index] = MappingType{key, value};
+  if (!comparator(key, keys[index])) {
+    values[index] = value;
     return -1;
   }
 
   /* shift */
-  for (int i = GetSize() - 1; i >= index; --i) {
-    swap(array[i], array[i + 1]);
-  }
-  array[index] = MappingType{key, value};
+  std::copy_backward(keys + index, keys + GetSize(), keys + GetSize() + 1);
+  std::copy_backward(values + index, values + GetSize(), values + GetSize() + 1);
+  keys[index] = key;
+  values[index] = value;
   IncreaseSize(1);
   return GetSize();
 }
 
+/**
+ * @brief
+ * append sorted items whose keys are greater than all the others, used when the tree is built bottom-up
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Append(const MappingType *items, int size) {
+  KeyType *keys = KeyArray() + GetSize();
+  ValueType *values = ValueArray() + GetSize();
+  for (int i = 0; i < size; ++i) {
+    keys[i] = items[i].first;
+    values[i] = items[i].second;
+  }
+  IncreaseSize(size);
+}
+
 /*****************************************************************************
  * SPLIT
  *****************************************************************************/
@@ -123,7 +162,7 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient) {
   int new_this_size = GetMinSize();
   int new_recipient_size = GetSize() - new_this_size;
 
-  recipient->CopyNFrom(array + new_this_size, new_recipient_size);
+  recipient->CopyNFrom(KeyArray() + new_this_size, ValueArray() + new_this_size, new_recipient_size);
 
   SetSize(new_this_size);
   recipient->SetSize(new_recipient_size);
@@ -134,9 +173,10 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient) {
  * copy starting from items, and copy {size} number of elements into me.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(MappingType *items, int size) {
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(const KeyType *keys, const ValueType *values, int size) {
   /* take care that the it might overflow */
-  std::copy(items, items + size, array + GetSize());
+  std::copy(keys, keys + size, KeyArray() + GetSize());
+  std::copy(values, values + size, ValueArray() + GetSize());
 
   IncreaseSize(size);
 }
@@ -153,11 +193,11 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(MappingType *items, int size) {
 INDEX_TEMPLATE_ARGUMENTS
 bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const {
   int index = KeyIndex(key, comparator);
-  if (index == -1 || comparator(KeyAt(index), key)) {
+  if (index == -1 || comparator(KeyArray()[index], key)) {
     return false;
   }
 
-  *value = array[index].second;
+  *value = ValueArray()[index];
   return true;
 }
 
@@ -173,7 +213,7 @@ bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, co
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator) {
   int index = KeyIndex(key, comparator);
-  if (index == -1 || comparator(KeyAt(index), key)) {
+  if (index == -1 || comparator(KeyArray()[index], key)) {
     return -1;
   }
 
@@ -183,9 +223,8 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::Remove(int index) {
-  for (int i = index + 1; i < GetSize(); ++i) {
-    swap(array[i - 1], array[i]);
-  }
+  std::copy(KeyArray() + index + 1, KeyArray() + GetSize(), KeyArray() + index);
+  std::copy(ValueArray() + index + 1, ValueArray() + GetSize(), ValueArray() + index);
   IncreaseSize(-1);
 }
 
@@ -198,7 +237,7 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::Remove(int index) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {
-  recipient->CopyNFrom(array, GetSize());
+  recipient->CopyNFrom(KeyArray(), ValueArray(), GetSize());
   SetSize(0);
 }
 
@@ -210,7 +249,7 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {
-  recipient->CopyLastFrom(array[0]);
+  recipient->CopyLastFrom(KeyArray()[0], ValueArray()[0]);
   Remove(0);
 }
 
@@ -218,8 +257,9 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient)
  * Copy the item into the end of my item list. (Append item to my array)
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const MappingType &item) {
-  array[GetSize()] = item;
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const KeyType &key, const ValueType &value) {
+  KeyArray()[GetSize()] = key;
+  ValueArray()[GetSize()] = value;
   IncreaseSize(1);
 }
 
@@ -230,7 +270,7 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const MappingType &item) {
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient) {
   IncreaseSize(-1);
-  recipient->CopyFirstFrom(array[GetSize()]);
+  recipient->CopyFirstFrom(KeyArray()[GetSize()], ValueArray()[GetSize()]);
 }
 
 /**
@@ -238,11 +278,11 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient)
  * insert item at the front
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(const MappingType &item) {
-  for (int i = GetSize() - 1; i >= 0; --i) {
-    swap(array[i], array[i + 1]);
-  }
-  array[0] = item;
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(const KeyType &key, const ValueType &value) {
+  std::copy_backward(KeyArray(), KeyArray() + GetSize(), KeyArray() + GetSize() + 1);
+  std::copy_backward(ValueArray(), ValueArray() + GetSize(), ValueArray() + GetSize() + 1);
+  KeyArray()[0] = key;
+  ValueArray()[0] = value;
   IncreaseSize(1);
 }
 
@@ -0,0 +1,116 @@
+#include "storage/page/table_page.h"
+
+namespace thomas {
+
+void TablePage::Init(int fsm_index) {
+  SetFreeSpacePointer(PAGE_SIZE);
+  SetSlotCount(0);
+  memcpy(GetData() + 8, &fsm_index, 4);
+}
+
+int TablePage::GetFreeSpace() {
+  return GetFreeSpacePointer() - TABLE_PAGE_HEADER_SIZE - GetSlotCount() * SLOT_SIZE;
+}
+
+int TablePage::GetSpaceNeeded(int size) { return FindEmptySlot() == -1 ? size + SLOT_SIZE : size; }
+
+int TablePage::GetFsmIndex() { return *reinterpret_cast<int *>(GetData() + 8); }
+
+int TablePage::GetSlotCount() { return *reinterpret_cast<int *>(GetData() + 4); }
+
+bool TablePage::InsertRecord(const char *data, int size, int *slot) {
+  if (GetSpaceNeeded(size) > GetFreeSpace()) {
+    return false;
+  }
+  *slot = FindEmptySlot();
+  if (*slot == -1) {
+    *slot = GetSlotCount();
+    SetSlotCount(*slot + 1);
+  }
+
+  /* the records grow towards the slot array */
+  int offset = GetFreeSpacePointer() - size;
+  memcpy(GetData() + offset, data, size);
+  SetFreeSpacePointer(offset);
+  SetSlot(*slot, offset, size);
+  return true;
+}
+
+const char *TablePage::GetRecord(int slot) {
+  if (slot < 0 || slot >= GetSlotCount() || GetSlotSize(slot) == 0) {
+    return nullptr;
+  }
+  return GetData() + GetSlotOffset(slot);
+}
+
+int TablePage::GetRecordSize(int slot) {
+  if (slot < 0 || slot >= GetSlotCount()) {
+    return 0;
+  }
+  return GetSlotSize(slot);
+}
+
+bool TablePage::UpdateRecord(int slot, const char *data, int size) {
+  if (slot < 0 || slot >= GetSlotCount() || GetSlotSize(slot) != size) {
+    return false;
+  }
+  memcpy(GetData() + GetSlotOffset(slot), data, size);
+  return true;
+}
+
+bool TablePage::DeleteRecord(int slot) {
+  if (slot < 0 || slot >= GetSlotCount() || GetSlotSize(slot) == 0) {
+    return false;
+  }
+  int offset = GetSlotOffset(slot);
+  int size = GetSlotSize(slot);
+  int free_space_pointer = GetFreeSpacePointer();
+
+  /* move the records nearer to the free space up, to close the hole */
+  memmove(GetData() + free_space_pointer + size, GetData() + free_space_pointer, offset - free_space_pointer);
+  for (int i = 0; i < GetSlotCount(); ++i) {
+    if (GetSlotSize(i) != 0 && GetSlotOffset(i) < offset) {
+      SetSlot(i, GetSlotOffset(i) + size, GetSlotSize(i));
+    }
+  }
+  SetFreeSpacePointer(free_space_pointer + size);
+  SetSlot(slot, 0, 0);
+
+  /* the empty slots at the end are given back */
+  int slot_count = GetSlotCount();
+  while (slot_count > 0 && GetSlotSize(slot_count - 1) == 0) {
+    --slot_count;
+  }
+  SetSlotCount(slot_count);
+  return true;
+}
+
+int TablePage::GetFreeSpacePointer() { return *reinterpret_cast<int *>(GetData()); }
+
+void TablePage::SetFreeSpacePointer(int free_space_pointer) { memcpy(GetData(), &free_space_pointer, 4); }
+
+void TablePage::SetSlotCount(int slot_count) { memcpy(GetData() + 4, &slot_count, 4); }
+
+int TablePage::GetSlotOffset(int slot) {
+  return *reinterpret_cast<int *>(GetData() + TABLE_PAGE_HEADER_SIZE + slot * SLOT_SIZE);
+}
+
+int TablePage::GetSlotSize(int slot) {
+  return *reinterpret_cast<int *>(GetData() + TABLE_PAGE_HEADER_SIZE + slot * SLOT_SIZE + 4);
+}
+
+void TablePage::SetSlot(int slot, int offset, int size) {
+  memcpy(GetData() + TABLE_PAGE_HEADER_SIZE + slot * SLOT_SIZE, &offset, 4);
+  memcpy(GetData() + TABLE_PAGE_HEADER_SIZE + slot * SLOT_SIZE + 4, &size, 4);
+}
+
+int TablePage::FindEmptySlot() {
+  for (int i = 0; i < GetSlotCount(); ++i) {
+    if (GetSlotSize(i) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+}  // namespace thomas
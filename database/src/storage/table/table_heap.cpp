@@ -0,0 +1,261 @@
+#include "storage/table/table_heap.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "common/exceptions.hpp"
+
+namespace thomas {
+
+/**
+ * @brief
+ * a table heap constructor
+ * @param file_name the name of the file holding the records
+ * @param buffer_pool_size the size of the buffer pool
+ * @param replacer_type the replacement policy of the buffer pool
+ * @param log_manager the write-ahead log of the pages, nullptr for none
+ */
+TableHeap::TableHeap(const std::string &file_name, int buffer_pool_size, REPLACER_TYPE replacer_type,
+                     LogManager *log_manager)
+    : log_manager_(log_manager) {
+  disk_manager_ = new DiskManager(file_name);
+  auto bpm =
+      new BufferPoolManagerInstance(buffer_pool_size, disk_manager_, THREAD_SAFE_TYPE::NON_THREAD_SAFE, replacer_type);
+  if (log_manager_ != nullptr) {
+    file_id_ = log_manager_->RegisterFile(file_name, [this](bool checkpoint) { Persist(checkpoint); });
+    bpm->SetLogManager(log_manager_, file_id_);
+  }
+  bpm_ = bpm;
+
+  /* some restore */
+  try {
+    header_page_ = static_cast<HeaderPage *>(bpm_->FetchPage(HEADER_PAGE_ID));
+    page_id_t next_page_id;
+    if (!header_page_->SearchRecord("page_amount", &next_page_id)) {
+      throw metadata_error();
+    }
+    disk_manager_->SetNextPageId(next_page_id);
+    LoadFreeSpaceMap();
+  } catch (read_less_then_a_page &error) {
+    bpm_->UnpinPage(HEADER_PAGE_ID, false);
+    bpm_->DeletePage(HEADER_PAGE_ID);
+    page_id_t header_page_id;
+    header_page_ = static_cast<HeaderPage *>(bpm_->NewPage(&header_page_id));
+    header_page_->InsertRecord("page_amount", 1);
+    header_page_->InsertRecord("fsm", INVALID_PAGE_ID);
+  }
+}
+
+TableHeap::~TableHeap() {
+  Flush();
+  bpm_->UnpinPage(HEADER_PAGE_ID, true);
+  if (log_manager_ != nullptr) {
+    log_manager_->UnregisterFile(file_id_);
+  }
+  disk_manager_->ShutDown();
+  delete disk_manager_;
+  delete bpm_;
+}
+
+/**
+ * @brief
+ * the page taking the inserts is used until it's full, then the pages that got room back from deletes, and at last a
+ * new page
+ * @param data
+ * @param size
+ * @return RID
+ */
+RID TableHeap::InsertRecord(const char *data, int size) {
+  int needed = size + TablePage::SLOT_SIZE;
+  if (current_ != -1 && free_space_map_[current_].free_space_ < needed) {
+    current_ = -1;
+  }
+  while (current_ == -1 && !candidates_.empty()) {
+    int index = candidates_.back();
+    candidates_.pop_back();
+    if (free_space_map_[index].free_space_ >= needed) {
+      current_ = index;
+    }
+  }
+
+  TablePage *page;
+  if (current_ == -1) {
+    page = NewTablePage();
+    current_ = page->GetFsmIndex();
+  } else {
+    page = static_cast<TablePage *>(bpm_->FetchPage(free_space_map_[current_].page_id_));
+  }
+  int slot;
+  page->InsertRecord(data, size, &slot);
+  free_space_map_[current_].free_space_ = page->GetFreeSpace();
+  is_map_changed_ = true;
+  RID rid(page->GetPageId(), slot);
+  bpm_->UnpinPage(rid.GetPageId(), true);
+  return rid;
+}
+
+bool TableHeap::GetRecord(const RID &rid, char *data) {
+  auto page = static_cast<TablePage *>(bpm_->FetchPage(rid.GetPageId()));
+  const char *record = page->GetRecord(rid.GetSlot());
+  if (record != nullptr) {
+    memcpy(data, record, page->GetRecordSize(rid.GetSlot()));
+  }
+  bpm_->UnpinPage(rid.GetPageId(), false);
+  return record != nullptr;
+}
+
+bool TableHeap::UpdateRecord(const RID &rid, const char *data, int size) {
+  auto page = static_cast<TablePage *>(bpm_->FetchPage(rid.GetPageId()));
+  bool success = page->UpdateRecord(rid.GetSlot(), data, size);
+  bpm_->UnpinPage(rid.GetPageId(), success);
+  return success;
+}
+
+bool TableHeap::DeleteRecord(const RID &rid) {
+  auto page = static_cast<TablePage *>(bpm_->FetchPage(rid.GetPageId()));
+  int size = page->GetRecordSize(rid.GetSlot());
+  if (!page->DeleteRecord(rid.GetSlot())) {
+    bpm_->UnpinPage(rid.GetPageId(), false);
+    return false;
+  }
+  int index = page->GetFsmIndex();
+  /* the page becomes a candidate once it has room for a record like this one again */
+  if (index != current_ && free_space_map_[index].free_space_ < size + TablePage::SLOT_SIZE) {
+    candidates_.push_back(index);
+  }
+  free_space_map_[index].free_space_ = page->GetFreeSpace();
+  is_map_changed_ = true;
+  bpm_->UnpinPage(rid.GetPageId(), true);
+  return true;
+}
+
+void TableHeap::Clear() {
+  if (log_manager_ != nullptr) {
+    log_manager_->Truncate(file_id_);
+  }
+  bpm_->Initialize();
+  disk_manager_->Clear();
+  page_id_t header_page_id;
+  header_page_ = static_cast<HeaderPage *>(bpm_->NewPage(&header_page_id));
+  header_page_->InsertRecord("page_amount", 1);
+  header_page_->InsertRecord("fsm", INVALID_PAGE_ID);
+  free_space_map_.clear();
+  candidates_.clear();
+  current_ = -1;
+  is_map_changed_ = false;
+}
+
+/**
+ * @brief
+ * checkpoint: write the free space map, the metadata and all the pages back, then sync the file
+ */
+void TableHeap::Flush() {
+  SyncHeader();
+  bpm_->FlushAllPages();
+  disk_manager_->Sync();
+}
+
+void TableHeap::SyncHeader() {
+  if (is_map_changed_) {
+    StoreFreeSpaceMap();
+    is_map_changed_ = false;
+  }
+  page_id_t page_amount;
+  header_page_->SearchRecord("page_amount", &page_amount);
+  if (page_amount != disk_manager_->GetNextPageId()) {
+    header_page_->UpdateRecord("page_amount", disk_manager_->GetNextPageId());
+    /* the header page stays pinned, so it's marked dirty by another pin */
+    bpm_->FetchPage(HEADER_PAGE_ID);
+    bpm_->UnpinPage(HEADER_PAGE_ID, true);
+  }
+}
+
+/**
+ * @brief
+ * at a commit, the free space map and the metadata are stored and the changed pages are logged; at a checkpoint, all
+ * the pages are written back and the file is synced
+ */
+void TableHeap::Persist(bool checkpoint) {
+  if (checkpoint) {
+    bpm_->FlushAllPages();
+    disk_manager_->Sync();
+    return;
+  }
+  SyncHeader();
+  bpm_->LogDirtyPages();
+}
+
+int TableHeap::GetPageNum() { return disk_manager_->GetNextPageId(); }
+
+TablePage *TableHeap::NewTablePage() {
+  page_id_t page_id;
+  auto page = static_cast<TablePage *>(bpm_->NewPage(&page_id));
+  page->Init(free_space_map_.size());
+  free_space_map_.push_back({page_id, page->GetFreeSpace()});
+  return page;
+}
+
+void TableHeap::LoadFreeSpaceMap() {
+  page_id_t page_id;
+  if (!header_page_->SearchRecord("fsm", &page_id)) {
+    throw metadata_error();
+  }
+  while (page_id != INVALID_PAGE_ID) {
+    Page *page = bpm_->FetchPage(page_id);
+    int count = *reinterpret_cast<int *>(page->GetData() + 4);
+    for (int i = 0; i < count; ++i) {
+      FreeSpaceEntry entry;
+      memcpy(&entry, page->GetData() + FSM_PAGE_HEADER_SIZE + i * sizeof(FreeSpaceEntry), sizeof(FreeSpaceEntry));
+      free_space_map_.push_back(entry);
+    }
+    page_id_t next_page_id = *reinterpret_cast<page_id_t *>(page->GetData());
+    bpm_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+
+  /* the last page takes the inserts, and every other page with some room is worth a try */
+  current_ = static_cast<int>(free_space_map_.size()) - 1;
+  for (int i = 0; i < current_; ++i) {
+    if (free_space_map_[i].free_space_ > TablePage::SLOT_SIZE) {
+      candidates_.push_back(i);
+    }
+  }
+}
+
+void TableHeap::StoreFreeSpaceMap() {
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  page_id_t page_id;
+  header_page_->SearchRecord("fsm", &page_id);
+  for (size_t begin = 0; begin < free_space_map_.size(); begin += FSM_PAGE_SIZE) {
+    Page *page;
+    if (page_id == INVALID_PAGE_ID) {
+      /* the map only grows, so the chain is extended at its tail */
+      page = bpm_->NewPage(&page_id);
+      page_id_t next_page_id = INVALID_PAGE_ID;
+      memcpy(page->GetData(), &next_page_id, 4);
+      if (prev_page_id == INVALID_PAGE_ID) {
+        header_page_->UpdateRecord("fsm", page_id);
+        bpm_->FetchPage(HEADER_PAGE_ID);
+        bpm_->UnpinPage(HEADER_PAGE_ID, true);
+      } else {
+        Page *prev_page = bpm_->FetchPage(prev_page_id);
+        memcpy(prev_page->GetData(), &page_id, 4);
+        bpm_->UnpinPage(prev_page_id, true);
+      }
+    } else {
+      page = bpm_->FetchPage(page_id);
+    }
+    int count = std::min(static_cast<size_t>(FSM_PAGE_SIZE), free_space_map_.size() - begin);
+    memcpy(page->GetData() + 4, &count, 4);
+    for (int i = 0; i < count; ++i) {
+      memcpy(page->GetData() + FSM_PAGE_HEADER_SIZE + i * sizeof(FreeSpaceEntry), &free_space_map_[begin + i],
+             sizeof(FreeSpaceEntry));
+    }
+    prev_page_id = page_id;
+    page_id = *reinterpret_cast<page_id_t *>(page->GetData());
+    bpm_->UnpinPage(prev_page_id, true);
+  }
+}
+
+}  // namespace thomas
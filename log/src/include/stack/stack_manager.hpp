@@ -1,20 +1,46 @@
 #pragma once
 
-#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
+#include <string>
+
+#include "recovery/log_manager.h"
+
 namespace thomas {
 
 #define STACK_TEMPLATE template <typename T>
 #define STACK_TYPE StackManager<T>
 
+static constexpr size_t STACK_BLOCK_SIZE = 1 << 15;  // size of a block of values in byte
+static constexpr size_t STACK_HEADER_SIZE = 4096;    // the values start after the header page
+
 /**
  * @brief
- * a stack on disk
+ * a stack on disk. The values are packed in blocks of STACK_BLOCK_SIZE after the header page, and the block on the top
+ * is kept in memory, so a push or a pop only touches the disk when it crosses a block. With mmap enabled, the file is
+ * mapped instead and grows by blocks.
+ *
+ * The header has two slots, each with the size, a sequence number and a checksum. They are written in turn, and the
+ * valid one with the greater sequence is read back, so a torn header write leaves the last one intact. It's written
+ * after the values it covers, at every block crossed and at Flush().
+ *
+ * With a log manager, the stack takes part in the commits of the indexes instead. The values pushed are logged as
+ * REDO records when their block is left or at the next commit, and the header as the start of page 0, so a commit
+ * costs no sync of the stack file, and a crash brings back the size of the last commit along with the indexes. The
+ * file is synced only at a checkpoint. The values below the committed size are only rewritten after a pop, so the
+ * pops have to be committed before the pushes after them.
  */
 STACK_TEMPLATE
 class StackManager {
  public:
-  explicit StackManager(const std::string &stack_name);
+  explicit StackManager(const std::string &stack_name, bool enable_mmap = false, LogManager *log_manager = nullptr);
 
   ~StackManager();
 
@@ -22,63 +48,162 @@ class StackManager {
 
   void Pop(T &value);
 
+  /* read the value on the top without popping it */
+  void Top(T &value);
+
   size_t Size();
 
   bool IsEmpty();
 
+  void Clear();
+
+  /* write the block in memory and the header, so that the stack survives a crash of the process. With a log manager,
+   * only the block is written, the header is left to the commits. */
+  void Flush();
+
  private:
-  std::fstream stack_io_;
+  struct Header {
+    uint64_t sequence_;
+    uint64_t size_;
+    uint64_t checksum_;
+  };
+
+  /* the number of values in a block, a value larger than a block takes a block of its own */
+  static constexpr size_t VALUE_NUM = sizeof(T) >= STACK_BLOCK_SIZE ? 1 : STACK_BLOCK_SIZE / sizeof(T);
+  static constexpr size_t BLOCK_SIZE = VALUE_NUM * sizeof(T);
+
+  static uint64_t Checksum(const Header &header);
+
+  void ReadHeader();
+
+  /* write the next header slot, only into the header page with a log manager */
+  void WriteHeader();
+
+  /* write the header page kept for the log manager */
+  void WriteHeaderPage();
+
+  /* sync the values written since the last sync */
+  void Sync();
+
+  /* log the values pushed since they were last logged, they are all in the block in memory without mmap */
+  void LogValues();
+
+  /* called by the log manager at a commit, or at a checkpoint */
+  void Persist(bool checkpoint);
+
+  /* the address of the value at the index, its block is loaded unless it's pushed at the start of a new block */
+  char *Locate(size_t index, bool is_push);
+
+  void WriteBlock();
+
+  /* map at least the size of the file */
+  void Remap(size_t size);
+
+  int fd_;
   std::string file_name_;
-  size_t sum_;
+  size_t sum_{0};
+  uint64_t sequence_{0};
+  bool enable_mmap_;
+
+  /* the block in memory without mmap */
+  char *block_{nullptr};
+  size_t block_id_{SIZE_MAX};
+  bool is_dirty_{false};
+
+  /* the mapping with mmap */
+  char *map_{nullptr};
+  size_t map_size_{0};
+
+  /* with a log manager, the header page as of its last record and now, only the headers at its start differ */
+  LogManager *log_manager_;
+  int file_id_{-1};
+  char *logged_header_{nullptr};
+  char *header_page_{nullptr};
+  size_t logged_sum_{0};
+  /* the lowest index pushed since the values were last logged */
+  size_t log_begin_{SIZE_MAX};
+  lsn_t header_lsn_{INVALID_LSN};
+  bool is_synced_{true};
 };
 
 STACK_TEMPLATE
-STACK_TYPE::StackManager(const std::string &stack_name) : file_name_(stack_name) {
+STACK_TYPE::StackManager(const std::string &stack_name, bool enable_mmap, LogManager *log_manager)
+    : file_name_(stack_name), enable_mmap_(enable_mmap), log_manager_(log_manager) {
   if (stack_name.rfind('.') == std::string::npos) {
     throw std::runtime_error("wrong file format");
   }
-  stack_io_.open(stack_name, std::ios::binary | std::ios::in | std::ios::out);
-  /* the file is not exist */
-  if (!stack_io_.is_open()) {
-    /* create a new file */
-    stack_io_.clear();
-    stack_io_.open(stack_name, std::ios::binary | std::ios::trunc | std::ios::out);
-    stack_io_.close();
-    stack_io_.open(stack_name, std::ios::binary | std::ios::in | std::ios::out);
+  fd_ = open(stack_name.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ == -1) {
+    throw std::runtime_error("can't open stack file");
+  }
+  if (enable_mmap_) {
+    struct stat file_stat;
+    if (fstat(fd_, &file_stat) == -1) {
+      throw std::runtime_error("I/O error while reading");
+    }
+    Remap(std::max(static_cast<size_t>(file_stat.st_size), STACK_HEADER_SIZE + BLOCK_SIZE));
   } else {
-    /* read exist data */
-    int offset = 0;
-    stack_io_.seekp(offset);
-    stack_io_.read(reinterpret_cast<char *>(&sum_), sizeof(size_t));
+    block_ = new char[BLOCK_SIZE];
+  }
+  if (log_manager_ != nullptr) {
+    logged_header_ = new char[PAGE_SIZE]();
+    header_page_ = new char[PAGE_SIZE]();
+  }
+  ReadHeader();
+  if (log_manager_ != nullptr) {
+    logged_sum_ = sum_;
+    file_id_ = log_manager_->RegisterFile(file_name_, [this](bool checkpoint) { Persist(checkpoint); });
   }
 }
 
 STACK_TEMPLATE
 STACK_TYPE::~StackManager() {
-  int offset = 0;
-  stack_io_.seekp(offset);
-  stack_io_.write(reinterpret_cast<char *>(&sum_), sizeof(size_t));
-  stack_io_.close();
+  if (log_manager_ != nullptr) {
+    /* like a page written back, the header is logged first, and undone in the recovery unless it's committed */
+    WriteBlock();
+    Sync();
+    if (sum_ != logged_sum_) {
+      WriteHeader();
+      header_lsn_ = log_manager_->AppendUpdate(file_id_, 0, logged_header_, header_page_);
+    }
+    log_manager_->Flush(header_lsn_);
+    WriteHeaderPage();
+    Sync();
+    log_manager_->UnregisterFile(file_id_);
+    delete[] logged_header_;
+    delete[] header_page_;
+  } else {
+    Flush();
+  }
+  if (enable_mmap_) {
+    munmap(map_, map_size_);
+  } else {
+    delete[] block_;
+  }
+  close(fd_);
 }
 
 STACK_TEMPLATE
 void STACK_TYPE::Push(const T &value) {
-  int offset = sizeof(size_t) + sizeof(T) * (sum_++);
-  stack_io_.seekp(offset);
-  stack_io_.write(reinterpret_cast<char *>(&value), sizeof(T));
-  if (stack_io_.bad()) {
-    throw std::runtime_error("I/O error while writing");
-  }
+  memcpy(Locate(sum_, true), &value, sizeof(T));
+  log_begin_ = std::min(log_begin_, sum_);
+  ++sum_;
+  is_dirty_ = true;
+  is_synced_ = false;
 }
 
 STACK_TEMPLATE
 void STACK_TYPE::Pop(T &value) {
-  int offset = sizeof(size_t) + sizeof(T) * (--sum_);
-  stack_io_.seekp(offset);
-  stack_io_.read(reinterpret_cast<char *>(&value), sizeof(T));
-  if (stack_io_.bad()) {
-    throw std::runtime_error("I/O error whilg reading");
+  Top(value);
+  --sum_;
+}
+
+STACK_TEMPLATE
+void STACK_TYPE::Top(T &value) {
+  if (sum_ == 0) {
+    throw std::runtime_error("pop from an empty stack");
   }
+  memcpy(&value, Locate(sum_ - 1, false), sizeof(T));
 }
 
 STACK_TEMPLATE
@@ -87,4 +212,205 @@ size_t STACK_TYPE::Size() { return sum_; }
 STACK_TEMPLATE
 bool STACK_TYPE::IsEmpty() { return sum_ == 0; }
 
-}  // namespace thomas
\ No newline at end of file
+STACK_TEMPLATE
+void STACK_TYPE::Clear() {
+  if (log_manager_ != nullptr) {
+    /* the truncation is committed on its own, then the file starts over */
+    log_manager_->Truncate(file_id_);
+    if (ftruncate(fd_, 0) == -1) {
+      throw std::runtime_error("I/O error while clearing");
+    }
+    if (enable_mmap_) {
+      Remap(STACK_HEADER_SIZE + BLOCK_SIZE);
+    }
+    memset(logged_header_, 0, PAGE_SIZE);
+    memset(header_page_, 0, PAGE_SIZE);
+    sum_ = logged_sum_ = 0;
+    log_begin_ = SIZE_MAX;
+    block_id_ = SIZE_MAX;
+    header_lsn_ = INVALID_LSN;
+    is_dirty_ = false;
+    is_synced_ = true;
+    return;
+  }
+  sum_ = 0;
+  is_dirty_ = false;
+  WriteHeader();
+}
+
+STACK_TEMPLATE
+void STACK_TYPE::Flush() {
+  WriteBlock();
+  if (log_manager_ == nullptr) {
+    WriteHeader();
+  }
+}
+
+STACK_TEMPLATE
+uint64_t STACK_TYPE::Checksum(const Header &header) {
+  uint64_t hash = header.sequence_ * 0x9e3779b97f4a7c15ULL ^ header.size_ * 0xc2b2ae3d27d4eb4fULL;
+  return hash ^ (hash >> 29) ^ 0x5354414bULL;
+}
+
+STACK_TEMPLATE
+void STACK_TYPE::ReadHeader() {
+  Header headers[2];
+  if (enable_mmap_) {
+    memcpy(headers, map_, sizeof(headers));
+  } else if (pread(fd_, headers, sizeof(headers), 0) != sizeof(headers)) {
+    /* a new file */
+    return;
+  }
+  for (int i = 0; i < 2; ++i) {
+    if (headers[i].checksum_ == Checksum(headers[i]) && headers[i].sequence_ >= sequence_) {
+      sequence_ = headers[i].sequence_ + 1;
+      sum_ = headers[i].size_;
+    }
+  }
+  if (log_manager_ != nullptr) {
+    memcpy(logged_header_, headers, sizeof(headers));
+    memcpy(header_page_, headers, sizeof(headers));
+  }
+}
+
+STACK_TEMPLATE
+void STACK_TYPE::WriteHeader() {
+  Header header{sequence_++, sum_, 0};
+  header.checksum_ = Checksum(header);
+  off_t offset = (header.sequence_ % 2) * sizeof(Header);
+  if (log_manager_ != nullptr) {
+    memcpy(header_page_ + offset, &header, sizeof(Header));
+  } else if (enable_mmap_) {
+    memcpy(map_ + offset, &header, sizeof(Header));
+  } else if (pwrite(fd_, &header, sizeof(Header), offset) != sizeof(Header)) {
+    throw std::runtime_error("I/O error while writing");
+  }
+}
+
+STACK_TEMPLATE
+void STACK_TYPE::WriteHeaderPage() {
+  if (enable_mmap_) {
+    memcpy(map_, header_page_, 2 * sizeof(Header));
+  } else if (pwrite(fd_, header_page_, 2 * sizeof(Header), 0) != 2 * sizeof(Header)) {
+    throw std::runtime_error("I/O error while writing");
+  }
+  is_synced_ = false;
+}
+
+STACK_TEMPLATE
+void STACK_TYPE::Sync() {
+  if (is_synced_) {
+    return;
+  }
+  is_synced_ = true;
+  if (enable_mmap_ ? msync(map_, map_size_, MS_SYNC) == -1 : fdatasync(fd_) == -1) {
+    throw std::runtime_error("I/O error while syncing");
+  }
+}
+
+STACK_TEMPLATE
+void STACK_TYPE::Persist(bool checkpoint) {
+  if (checkpoint) {
+    /* the commit before is on disk, and so are the values and the header logged by it */
+    WriteBlock();
+    WriteHeaderPage();
+    Sync();
+    header_lsn_ = INVALID_LSN;
+    return;
+  }
+  /* the values are redone along with the header covering them, so the file isn't synced */
+  LogValues();
+  if (sum_ != logged_sum_) {
+    WriteHeader();
+    header_lsn_ = log_manager_->AppendUpdate(file_id_, 0, logged_header_, header_page_, false);
+    logged_sum_ = sum_;
+  }
+}
+
+STACK_TEMPLATE
+void STACK_TYPE::LogValues() {
+  if (log_begin_ >= sum_) {
+    log_begin_ = SIZE_MAX;
+    return;
+  }
+  size_t begin = STACK_HEADER_SIZE + log_begin_ * sizeof(T);
+  size_t end = STACK_HEADER_SIZE + sum_ * sizeof(T);
+  const char *data = enable_mmap_ ? map_ + begin : block_ + (log_begin_ - block_id_ * VALUE_NUM) * sizeof(T);
+  /* a record for each page the values cover */
+  while (begin < end) {
+    size_t page_end = std::min(end, (begin / PAGE_SIZE + 1) * PAGE_SIZE);
+    log_manager_->AppendRedo(file_id_, static_cast<page_id_t>(begin / PAGE_SIZE), static_cast<int>(begin % PAGE_SIZE),
+                             data, static_cast<int>(page_end - begin));
+    data += page_end - begin;
+    begin = page_end;
+  }
+  log_begin_ = SIZE_MAX;
+}
+
+STACK_TEMPLATE
+char *STACK_TYPE::Locate(size_t index, bool is_push) {
+  if (enable_mmap_) {
+    size_t offset = STACK_HEADER_SIZE + index * sizeof(T);
+    if (offset + sizeof(T) > map_size_) {
+      Remap(std::max(2 * map_size_, offset + BLOCK_SIZE));
+    }
+    return map_ + offset;
+  }
+
+  size_t block_id = index / VALUE_NUM;
+  if (block_id != block_id_) {
+    /* all the values below the top are on disk once the block is written, so is the header */
+    if (log_manager_ != nullptr) {
+      LogValues();
+    }
+    WriteBlock();
+    block_id_ = block_id;
+    if (!is_push || index % VALUE_NUM != 0) {
+      ssize_t size = pread(fd_, block_, BLOCK_SIZE, STACK_HEADER_SIZE + block_id * BLOCK_SIZE);
+      if (size == -1) {
+        throw std::runtime_error("I/O error while reading");
+      }
+    }
+    if (log_manager_ == nullptr) {
+      WriteHeader();
+    }
+  }
+  return block_ + index % VALUE_NUM * sizeof(T);
+}
+
+STACK_TEMPLATE
+void STACK_TYPE::WriteBlock() {
+  if (enable_mmap_ || !is_dirty_) {
+    return;
+  }
+  is_dirty_ = false;
+  /* the block is only written up to the top */
+  size_t value_num = std::min(sum_ - std::min(sum_, block_id_ * VALUE_NUM), VALUE_NUM);
+  if (value_num == 0) {
+    return;
+  }
+  size_t size = value_num * sizeof(T);
+  if (pwrite(fd_, block_, size, STACK_HEADER_SIZE + block_id_ * BLOCK_SIZE) != static_cast<ssize_t>(size)) {
+    throw std::runtime_error("I/O error while writing");
+  }
+  is_synced_ = false;
+}
+
+STACK_TEMPLATE
+void STACK_TYPE::Remap(size_t size) {
+  size = (size + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+  if (ftruncate(fd_, size) == -1) {
+    throw std::runtime_error("I/O error while growing stack");
+  }
+  if (map_ != nullptr) {
+    munmap(map_, map_size_);
+  }
+  map_ = static_cast<char *>(mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0));
+  if (map_ == MAP_FAILED) {
+    map_ = nullptr;
+    throw std::runtime_error("can't map stack file");
+  }
+  map_size_ = size;
+}
+
+}  // namespace thomas